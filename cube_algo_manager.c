@@ -1,11 +1,32 @@
 #include <gtk/gtk.h>
 #include <json-glib/json-glib.h>
+#include <cairo-pdf.h>
+#include <cairo-svg.h>
+#include <sqlite3.h>
+#include <ctype.h>
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
 
 #define MAX_ALGOS 1000
 #define DATA_FILE "cube_algorithms.json"
+#define DB_FILE "cube_algorithms.db"
+#define SETTINGS_FILE "cube_algo_manager.ini"
+#define MAX_SEARCH_RESULTS 200
+#define MAX_PATTERN_LEN 64
+#define LIST_PAGE_SIZE 200      // rows paged into the list at a time
+#define SCAN_PAGE_SIZE 4096     // rows per batch for export and the duplicate scan
+#define PAGE_START G_MININT64   // cursor before the first id
+#define BLANK_PATTERN_KEY "YYYYYYYYYXXXXXXXXXXXX"   // the form's reset colors
+
+#define SHEET_WIDTH 595.0     // A4 in points
+#define SHEET_HEIGHT 842.0
+#define SHEET_MARGIN 30.0
+#define SHEET_COLS 4
+#define SHEET_ROWS 5
+#define PNG_SCALE 2.0
+
+#define CUBE_FACELETS 54
 
 typedef struct {
     char name[256];
@@ -17,16 +38,99 @@ typedef struct {
     char side_back[3];
     char side_left[3];
     int id;
+    guint sync_hash;    // content hash as last read from / written to DATA_FILE
 } Algorithm;
 
 typedef struct {
+    char text[MAX_PATTERN_LEN + 1];
+    int length;
+    int max_errors;
+    guint64 masks[256];         // case-insensitive, for name and type
+    guint64 exact_masks[256];   // case-sensitive, since r and R are different moves
+} SearchPattern;
+
+typedef struct {
+    int score;
+    int id;
+    int slot;                   // where the caller keeps the row itself
+} SearchHit;
+
+typedef enum {
+    EXPORT_PDF,
+    EXPORT_SVG,
+    EXPORT_PNG
+} ExportFormat;
+
+typedef struct {
+    Algorithm *algos;           // snapshot of the exported rows, owned by the job
+    int count;
+    int page_count;
+    ExportFormat format;
+    char *path_base;            // target path without extension
+    const char *extension;
+    cairo_surface_t **pages;    // PDF only: one recording surface per page
+    gint failed;
+    GtkWidget *button;          // disabled while the export runs
+    GtkWidget *window;
+} ExportJob;
+
+typedef struct {
+    guchar f[CUBE_FACELETS];    // f[p] = solved-cube facelet now sitting at position p
+} CubeState;
+
+typedef struct {
+    char name;
+    int axis[3];                // outward normal of the face the turn is named after
+    int lo, hi;                 // layers turned: lo <= dot(position, axis) <= hi
+} MoveSpec;
+
+typedef struct {
+    const Algorithm *algos;
+    CubeState *states;          // AUF-normalized effect of each formula
+    gboolean *valid;            // FALSE when the formula could not be simulated
+    int count;
+    int chunk_size;
+} DuplicateScan;
+
+typedef struct AppData AppData;
+
+/*
+ * Everything outside the backends reads rows through these hooks; only the
+ * JSON backend keeps the library in app->algos.
+ */
+typedef struct {
+    gboolean (*open)(AppData *app);
+    void (*sync)(AppData *app);         // merge outside changes before a write, may be NULL
+    gboolean (*save_algo)(AppData *app, Algorithm *algo);     // insert or update by id
+    gboolean (*delete_algos)(AppData *app, const int *ids, int count);
+    gboolean (*get_algo)(AppData *app, int id, Algorithm *out);
+    // Up to n rows with id above *cursor in id order (type NULL for all); advances *cursor.
+    int (*page)(AppData *app, const char *type, gint64 *cursor, int n, Algorithm *out);
+    // The k best matches, best first, with their scores.
+    int (*search)(AppData *app, const SearchPattern *pattern, const char *type,
+                  int k, Algorithm *out, int *scores);
+    // Any other record with this algo_pattern_key.
+    gboolean (*find_pattern)(AppData *app, const char *key, int exclude_id, Algorithm *out);
+} StorageBackend;
+
+struct AppData {
     Algorithm algos[MAX_ALGOS];
     int count;
     
     GtkWidget *window;
     GtkWidget *list_view;
     GtkWidget *search_entry;
+    GtkWidget *type_filter_combo;
     GtkListStore *list_store;
+    const StorageBackend *backend;
+    GFileMonitor *file_monitor;
+    sqlite3 *db;
+    gboolean fts_ready;
+    int rows_not_loaded;
+    SearchPattern search;
+    char *type_filter;          // NULL shows every type
+    gint64 list_cursor;         // last id paged in while no search is active
+    gboolean list_more;
     
     GtkWidget *form_window;
     GtkWidget *name_entry;
@@ -39,21 +143,25 @@ typedef struct {
     
     GtkWidget *cube_buttons[9];
     GtkWidget *side_buttons[4][3];
-} AppData;
+};
 
 const char colors[] = {'Y', 'O', 'B', 'R', 'G', 'W', 'X'};
 
-void set_button_color(GtkWidget *button, char color) {
-    GdkRGBA rgba;
+const char *sticker_hex(char color) {
     switch(color) {
-        case 'Y': gdk_rgba_parse(&rgba, "#FBBF24"); break;
-        case 'O': gdk_rgba_parse(&rgba, "#F97316"); break;
-        case 'B': gdk_rgba_parse(&rgba, "#3B82F6"); break;
-        case 'R': gdk_rgba_parse(&rgba, "#EF4444"); break;
-        case 'G': gdk_rgba_parse(&rgba, "#10B981"); break;
-        case 'W': gdk_rgba_parse(&rgba, "#FFFFFF"); break;
-        default: gdk_rgba_parse(&rgba, "#D1D5DB"); break;
+        case 'Y': return "#FBBF24";
+        case 'O': return "#F97316";
+        case 'B': return "#3B82F6";
+        case 'R': return "#EF4444";
+        case 'G': return "#10B981";
+        case 'W': return "#FFFFFF";
+        default: return "#D1D5DB";
     }
+}
+
+void set_button_color(GtkWidget *button, char color) {
+    GdkRGBA rgba;
+    gdk_rgba_parse(&rgba, sticker_hex(color));
     
     GtkStyleContext *context = gtk_widget_get_style_context(button);
     GtkCssProvider *provider = gtk_css_provider_new();
@@ -97,7 +205,38 @@ void on_side_button_clicked(GtkWidget *widget, gpointer data) {
     set_button_color(widget, app->current_sides[side][index]);
 }
 
-void save_to_file(AppData *app) {
+guint32 hash_bytes(guint32 hash, const char *data, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+        hash = (hash ^ (guchar)data[i]) * 16777619u;
+    }
+    return hash;
+}
+
+guint algo_content_hash(const Algorithm *algo) {
+    guint32 hash = 2166136261u;
+    hash = hash_bytes(hash, algo->name, strlen(algo->name) + 1);
+    hash = hash_bytes(hash, algo->type, strlen(algo->type) + 1);
+    hash = hash_bytes(hash, algo->formula, strlen(algo->formula) + 1);
+    hash = hash_bytes(hash, algo->top_layer, 9);
+    hash = hash_bytes(hash, algo->side_front, 3);
+    hash = hash_bytes(hash, algo->side_right, 3);
+    hash = hash_bytes(hash, algo->side_back, 3);
+    hash = hash_bytes(hash, algo->side_left, 3);
+    return hash ? hash : 1;    // 0 is reserved for "never synced"
+}
+
+// Top layer then front, right, back and left strips: 21 sticker letters.
+void algo_pattern_key(const Algorithm *algo, char *key) {
+    snprintf(key, 22, "%.9s%.3s%.3s%.3s%.3s", algo->top_layer, algo->side_front,
+             algo->side_right, algo->side_back, algo->side_left);
+}
+
+gboolean save_to_file(AppData *app) {
+    // Rewriting the file would drop the records that did not fit in memory.
+    if (app->rows_not_loaded > 0) {
+        return FALSE;
+    }
+    
     JsonBuilder *builder = json_builder_new();
     json_builder_begin_array(builder);
     
@@ -148,328 +287,2136 @@ void save_to_file(AppData *app) {
         
         json_builder_end_object(builder);
     }
-    
-    json_builder_end_array(builder);
-    
-    JsonGenerator *gen = json_generator_new();
-    JsonNode *root = json_builder_get_root(builder);
-    json_generator_set_root(gen, root);
-    json_generator_set_pretty(gen, TRUE);
-    
-    json_generator_to_file(gen, DATA_FILE, NULL);
-    
-    json_node_free(root);
-    g_object_unref(gen);
-    g_object_unref(builder);
+    
+    json_builder_end_array(builder);
+    
+    JsonGenerator *gen = json_generator_new();
+    JsonNode *root = json_builder_get_root(builder);
+    json_generator_set_root(gen, root);
+    json_generator_set_pretty(gen, TRUE);
+    
+    gboolean ok = json_generator_to_file(gen, DATA_FILE, NULL);
+    if (ok) {
+        for (int i = 0; i < app->count; i++) {
+            app->algos[i].sync_hash = algo_content_hash(&app->algos[i]);
+        }
+    }
+    
+    json_node_free(root);
+    g_object_unref(gen);
+    g_object_unref(builder);
+    return ok;
+}
+
+void parse_algorithm(JsonObject *obj, Algorithm *algo) {
+    algo->id = json_object_get_int_member(obj, "id");
+    
+    const char *name = json_object_get_string_member(obj, "name");
+    if (name) strncpy(algo->name, name, 255);
+    
+    const char *type = json_object_get_string_member(obj, "type");
+    if (type) strncpy(algo->type, type, 63);
+    
+    const char *formula = json_object_get_string_member(obj, "formula");
+    if (formula) strncpy(algo->formula, formula, 1023);
+    
+    const char *top = json_object_get_string_member(obj, "top_layer");
+    if (top && strlen(top) >= 9) {
+        memcpy(algo->top_layer, top, 9);
+    }
+    
+    const char *front = json_object_get_string_member(obj, "side_front");
+    if (front && strlen(front) >= 3) {
+        memcpy(algo->side_front, front, 3);
+    }
+    
+    const char *right = json_object_get_string_member(obj, "side_right");
+    if (right && strlen(right) >= 3) {
+        memcpy(algo->side_right, right, 3);
+    }
+    
+    const char *back = json_object_get_string_member(obj, "side_back");
+    if (back && strlen(back) >= 3) {
+        memcpy(algo->side_back, back, 3);
+    }
+    
+    const char *left = json_object_get_string_member(obj, "side_left");
+    if (left && strlen(left) >= 3) {
+        memcpy(algo->side_left, left, 3);
+    }
+}
+
+JsonArray *read_data_file(JsonParser *parser) {
+    if (!g_file_test(DATA_FILE, G_FILE_TEST_EXISTS)) {
+        return NULL;
+    }
+    
+    GError *error = NULL;
+    if (!json_parser_load_from_file(parser, DATA_FILE, &error)) {
+        if (error) {
+            g_error_free(error);
+        }
+        return NULL;
+    }
+    
+    JsonNode *root = json_parser_get_root(parser);
+    if (!root || !JSON_NODE_HOLDS_ARRAY(root)) {
+        return NULL;
+    }
+    
+    return json_node_get_array(root);
+}
+
+void load_from_file(AppData *app) {
+    JsonParser *parser = json_parser_new();
+    JsonArray *array = read_data_file(parser);
+    if (!array) {
+        g_object_unref(parser);
+        return;
+    }
+    
+    guint len = json_array_get_length(array);
+    
+    app->count = 0;
+    app->rows_not_loaded = 0;
+    for (guint i = 0; i < len; i++) {
+        JsonObject *obj = json_array_get_object_element(array, i);
+        if (!obj) continue;
+        
+        if (app->count >= MAX_ALGOS) {
+            app->rows_not_loaded++;
+            continue;
+        }
+        
+        Algorithm *algo = &app->algos[app->count];
+        parse_algorithm(obj, algo);
+        algo->sync_hash = algo_content_hash(algo);
+        
+        app->count++;
+    }
+    
+    g_object_unref(parser);
+}
+
+void compile_search_pattern(SearchPattern *pattern, const char *text) {
+    memset(pattern, 0, sizeof(SearchPattern));
+    pattern->length = MIN((int)strlen(text), MAX_PATTERN_LEN);
+    pattern->max_errors = MIN(pattern->length / 4, 3);
+    memcpy(pattern->text, text, pattern->length);
+    
+    for (int i = 0; i < pattern->length; i++) {
+        guchar c = (guchar)text[i];
+        guint64 bit = (guint64)1 << i;
+        pattern->masks[tolower(c)] |= bit;
+        pattern->masks[toupper(c)] |= bit;
+        pattern->exact_masks[c] |= bit;
+    }
+}
+
+/*
+ * Bitap (shift-and) approximate substring search: R[d] holds the pattern
+ * prefixes that end at the current character with at most d edits. Returns
+ * the fewest edits for which the whole pattern occurs in text, or -1.
+ */
+int bitap_errors(const SearchPattern *pattern, const guint64 *masks, const char *text) {
+    guint64 state[4];
+    guint64 accept = (guint64)1 << (pattern->length - 1);
+    int k = pattern->max_errors;
+    int best = -1;
+    
+    for (int d = 0; d <= k; d++) {
+        state[d] = ((guint64)1 << d) - 1;
+    }
+    
+    for (const char *p = text; *p; p++) {
+        guint64 mask = masks[(guchar)*p];
+        guint64 prev = state[0];
+        state[0] = ((state[0] << 1) | 1) & mask;
+        
+        for (int d = 1; d <= k; d++) {
+            guint64 old = state[d];
+            state[d] = (((old << 1) | 1) & mask) |   // match
+                       ((prev << 1) | 1) |           // substitution
+                       prev |                        // extra text character
+                       (state[d - 1] << 1);          // missing text character
+            prev = old;
+        }
+        
+        for (int d = 0; d <= (best < 0 ? k : best - 1); d++) {
+            if (state[d] & accept) {
+                best = d;
+                break;
+            }
+        }
+        if (best == 0) break;
+    }
+    return best;
+}
+
+int field_score(const SearchPattern *pattern, const guint64 *masks, const char *text, int weight) {
+    int errors = bitap_errors(pattern, masks, text);
+    return errors < 0 ? 0 : weight * (pattern->max_errors + 1 - errors);
+}
+
+int algo_search_score(const SearchPattern *pattern, const Algorithm *algo) {
+    if (pattern->length == 0) {
+        return 1;
+    }
+    
+    int score = field_score(pattern, pattern->masks, algo->name, 4);
+    
+    // "sune" should rank Sune above Antisune: favour matches covering the whole name.
+    if (score > 0 && abs((int)strlen(algo->name) - pattern->length) <= pattern->max_errors) {
+        score += 2;
+    }
+    
+    return score +
+           field_score(pattern, pattern->masks, algo->type, 2) +
+           field_score(pattern, pattern->exact_masks, algo->formula, 1);
+}
+
+int filtered_score(const SearchPattern *pattern, const char *type, const Algorithm *algo) {
+    if (type && strcmp(algo->type, type) != 0) {
+        return 0;
+    }
+    return algo_search_score(pattern, algo);
+}
+
+// Ties go to the lower id, which is also the order the list pages in.
+gboolean hit_better(const SearchHit *a, const SearchHit *b) {
+    return a->score > b->score || (a->score == b->score && a->id < b->id);
+}
+
+void sift_down_hits(SearchHit *heap, int size, int i) {
+    for (;;) {
+        int worst = i;
+        int left = 2 * i + 1;
+        int right = left + 1;
+        if (left < size && hit_better(&heap[worst], &heap[left])) worst = left;
+        if (right < size && hit_better(&heap[worst], &heap[right])) worst = right;
+        if (worst == i) return;
+        
+        SearchHit tmp = heap[i];
+        heap[i] = heap[worst];
+        heap[worst] = tmp;
+        i = worst;
+    }
+}
+
+/*
+ * Bounded heap with the weakest hit at the root, so only the top results
+ * are kept. Returns the slot the caller should store the row in (the
+ * evicted hit's slot once full), or -1 if the hit did not make the cut.
+ */
+int push_hit(SearchHit *heap, int *size, int capacity, int score, int id) {
+    SearchHit hit = {score, id, *size};
+    
+    if (*size == capacity) {
+        if (!hit_better(&hit, &heap[0])) {
+            return -1;
+        }
+        hit.slot = heap[0].slot;
+        heap[0] = hit;
+        sift_down_hits(heap, *size, 0);
+        return hit.slot;
+    }
+    
+    int i = (*size)++;
+    heap[i] = hit;
+    while (i > 0 && hit_better(&heap[(i - 1) / 2], &heap[i])) {
+        SearchHit tmp = heap[i];
+        heap[i] = heap[(i - 1) / 2];
+        heap[(i - 1) / 2] = tmp;
+        i = (i - 1) / 2;
+    }
+    return hit.slot;
+}
+
+SearchHit pop_hit(SearchHit *heap, int *size) {
+    SearchHit root = heap[0];
+    heap[0] = heap[--(*size)];
+    sift_down_hits(heap, *size, 0);
+    return root;
+}
+
+// Empties the heap into out, best first; scores may be NULL.
+int drain_hits(SearchHit *heap, int size, const Algorithm *slots, Algorithm *out, int *scores) {
+    int n = size;
+    for (int i = n - 1; i >= 0; i--) {
+        SearchHit hit = pop_hit(heap, &size);
+        out[i] = slots[hit.slot];
+        if (scores) scores[i] = hit.score;
+    }
+    return n;
+}
+
+void set_list_row(AppData *app, GtkTreeIter *iter, const Algorithm *algo, int score) {
+    gtk_list_store_set(app->list_store, iter,
+                      0, algo->name,
+                      1, algo->type,
+                      2, algo->formula,
+                      3, algo->id,
+                      4, score,
+                      -1);
+}
+
+// Without a search the list shows the library in id order, a page at a time.
+void load_list_page(AppData *app) {
+    Algorithm *rows = g_new(Algorithm, LIST_PAGE_SIZE);
+    int n = app->backend->page(app, app->type_filter, &app->list_cursor, LIST_PAGE_SIZE, rows);
+    
+    for (int i = 0; i < n; i++) {
+        GtkTreeIter iter;
+        gtk_list_store_append(app->list_store, &iter);
+        set_list_row(app, &iter, &rows[i], 1);
+    }
+    app->list_more = n == LIST_PAGE_SIZE;
+    g_free(rows);
+}
+
+void refresh_list(AppData *app) {
+    gtk_list_store_clear(app->list_store);
+    
+    compile_search_pattern(&app->search, gtk_entry_get_text(GTK_ENTRY(app->search_entry)));
+    
+    g_free(app->type_filter);
+    app->type_filter = NULL;
+    if (gtk_combo_box_get_active(GTK_COMBO_BOX(app->type_filter_combo)) > 0) {
+        app->type_filter = gtk_combo_box_text_get_active_text(GTK_COMBO_BOX_TEXT(app->type_filter_combo));
+    }
+    
+    app->list_cursor = PAGE_START;
+    app->list_more = FALSE;
+    
+    if (app->search.length == 0) {
+        load_list_page(app);
+        return;
+    }
+    
+    Algorithm *hits = g_new(Algorithm, MAX_SEARCH_RESULTS);
+    int scores[MAX_SEARCH_RESULTS];
+    int n = app->backend->search(app, &app->search, app->type_filter,
+                                 MAX_SEARCH_RESULTS, hits, scores);
+    
+    for (int i = 0; i < n; i++) {
+        GtkTreeIter iter;
+        gtk_list_store_append(app->list_store, &iter);
+        set_list_row(app, &iter, &hits[i], scores[i]);
+    }
+    g_free(hits);
+}
+
+// Pages the next rows in as the list is scrolled towards its end.
+void on_list_scrolled(GtkAdjustment *adjustment, gpointer data) {
+    AppData *app = (AppData *)data;
+    if (!app->list_more) return;
+    
+    double page = gtk_adjustment_get_page_size(adjustment);
+    if (gtk_adjustment_get_value(adjustment) + 2 * page >= gtk_adjustment_get_upper(adjustment)) {
+        load_list_page(app);
+    }
+}
+
+gboolean find_list_row(AppData *app, int id, GtkTreeIter *iter) {
+    GtkTreeModel *model = GTK_TREE_MODEL(app->list_store);
+    gboolean valid = gtk_tree_model_get_iter_first(model, iter);
+    
+    while (valid) {
+        int row_id;
+        gtk_tree_model_get(model, iter, 3, &row_id, -1);
+        if (row_id == id) {
+            return TRUE;
+        }
+        valid = gtk_tree_model_iter_next(model, iter);
+    }
+    return FALSE;
+}
+
+// A full ranked list may be hiding matches that outrank a row moving down or out.
+gboolean list_at_capacity(AppData *app) {
+    return app->search.length > 0 &&
+           gtk_tree_model_iter_n_children(GTK_TREE_MODEL(app->list_store), NULL) >= MAX_SEARCH_RESULTS;
+}
+
+void update_list_row(AppData *app, const Algorithm *algo) {
+    GtkTreeModel *model = GTK_TREE_MODEL(app->list_store);
+    int score = filtered_score(&app->search, app->type_filter, algo);
+    GtkTreeIter iter;
+    
+    if (find_list_row(app, algo->id, &iter)) {
+        int row_score;
+        gtk_tree_model_get(model, &iter, 4, &row_score, -1);
+        if (row_score == score) {
+            set_list_row(app, &iter, algo, score);
+            return;
+        }
+        if (score < row_score && list_at_capacity(app)) {
+            refresh_list(app);
+            return;
+        }
+        gtk_list_store_remove(app->list_store, &iter);
+    }
+    
+    if (score == 0) return;
+    
+    // Rows past the last page will come in with a later page.
+    if (app->list_more && algo->id > app->list_cursor) return;
+    
+    // Keep the ranking: insert before the first row that hit_better puts below it.
+    GtkTreeIter sibling;
+    gboolean valid = gtk_tree_model_get_iter_first(model, &sibling);
+    while (valid) {
+        int row_score, row_id;
+        gtk_tree_model_get(model, &sibling, 3, &row_id, 4, &row_score, -1);
+        if (row_score < score || (row_score == score && row_id > algo->id)) break;
+        valid = gtk_tree_model_iter_next(model, &sibling);
+    }
+    gtk_list_store_insert_before(app->list_store, &iter, valid ? &sibling : NULL);
+    set_list_row(app, &iter, algo, score);
+    
+    int rows = gtk_tree_model_iter_n_children(model, NULL);
+    if (app->search.length > 0 && rows > MAX_SEARCH_RESULTS) {
+        GtkTreeIter last;
+        gtk_tree_model_iter_nth_child(model, &last, NULL, rows - 1);
+        gtk_list_store_remove(app->list_store, &last);
+    }
+}
+
+// Call after the record has left the store, so a re-rank does not bring it back.
+void remove_list_row(AppData *app, int id) {
+    GtkTreeIter iter;
+    if (!find_list_row(app, id, &iter)) return;
+    
+    if (list_at_capacity(app)) {
+        refresh_list(app);
+    } else {
+        gtk_list_store_remove(app->list_store, &iter);
+    }
+}
+
+int find_algo_index(AppData *app, int id) {
+    for (int i = 0; i < app->count; i++) {
+        if (app->algos[i].id == id) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+void remove_algo_at(AppData *app, int index) {
+    for (int j = index; j < app->count - 1; j++) {
+        app->algos[j] = app->algos[j + 1];
+    }
+    app->count--;
+}
+
+void insert_algo_at(AppData *app, int index, const Algorithm *algo) {
+    for (int j = app->count; j > index; j--) {
+        app->algos[j] = app->algos[j - 1];
+    }
+    app->algos[index] = *algo;
+    app->count++;
+}
+
+gboolean has_local_changes(AppData *app, const Algorithm *algo) {
+    return algo->id == app->editing_id || algo_content_hash(algo) != algo->sync_hash;
+}
+
+/*
+ * Three-way merge of DATA_FILE into memory, keyed by id. sync_hash is the
+ * common base: records the file did not touch are skipped, records only
+ * changed on disk are patched in place (store and list row), and records
+ * with local changes (or open in the form) keep the local copy so the next
+ * save_to_file writes it back.
+ */
+void sync_from_file(AppData *app) {
+    JsonParser *parser = json_parser_new();
+    JsonArray *array = read_data_file(parser);
+    if (!array) {
+        g_object_unref(parser);
+        return;
+    }
+    
+    GHashTable *seen = g_hash_table_new(g_direct_hash, g_direct_equal);
+    guint len = json_array_get_length(array);
+    int skipped = 0;
+    
+    for (guint i = 0; i < len; i++) {
+        JsonObject *obj = json_array_get_object_element(array, i);
+        if (!obj) continue;
+        
+        Algorithm disk;
+        memset(&disk, 0, sizeof(Algorithm));
+        parse_algorithm(obj, &disk);
+        disk.sync_hash = algo_content_hash(&disk);
+        g_hash_table_add(seen, GINT_TO_POINTER(disk.id));
+        
+        int index = find_algo_index(app, disk.id);
+        if (index < 0) {
+            if (app->count >= MAX_ALGOS) {
+                skipped++;
+                continue;
+            }
+            app->algos[app->count] = disk;
+            update_list_row(app, &app->algos[app->count]);
+            app->count++;
+            continue;
+        }
+        
+        Algorithm *algo = &app->algos[index];
+        if (disk.sync_hash == algo->sync_hash || has_local_changes(app, algo)) {
+            continue;
+        }
+        
+        *algo = disk;
+        update_list_row(app, algo);
+    }
+    
+    for (int i = app->count - 1; i >= 0; i--) {
+        Algorithm *algo = &app->algos[i];
+        if (g_hash_table_contains(seen, GINT_TO_POINTER(algo->id)) ||
+            algo->sync_hash == 0 || has_local_changes(app, algo)) {
+            continue;
+        }
+        
+        int id = algo->id;
+        remove_algo_at(app, i);
+        remove_list_row(app, id);
+    }
+    
+    app->rows_not_loaded = skipped;
+    g_hash_table_destroy(seen);
+    g_object_unref(parser);
+}
+
+void on_data_file_changed(GFileMonitor *monitor, GFile *file, GFile *other_file,
+                          GFileMonitorEvent event, gpointer data) {
+    AppData *app = (AppData *)data;
+    
+    if (event == G_FILE_MONITOR_EVENT_CHANGES_DONE_HINT ||
+        event == G_FILE_MONITOR_EVENT_CREATED) {
+        sync_from_file(app);
+    }
+}
+
+gboolean json_open(AppData *app) {
+    load_from_file(app);
+    
+    GFile *data_file = g_file_new_for_path(DATA_FILE);
+    app->file_monitor = g_file_monitor_file(data_file, G_FILE_MONITOR_NONE, NULL, NULL);
+    if (app->file_monitor) {
+        g_signal_connect(app->file_monitor, "changed", G_CALLBACK(on_data_file_changed), app);
+    }
+    g_object_unref(data_file);
+    return TRUE;
+}
+
+// Memory is put back if the file cannot be written, so it matches what is stored.
+gboolean json_save_algo(AppData *app, Algorithm *algo) {
+    int index = find_algo_index(app, algo->id);
+    Algorithm previous;
+    
+    if (index >= 0) {
+        previous = app->algos[index];
+        app->algos[index] = *algo;
+    } else {
+        if (app->count >= MAX_ALGOS) return FALSE;
+        app->algos[app->count++] = *algo;
+    }
+    
+    if (!save_to_file(app)) {
+        if (index >= 0) {
+            app->algos[index] = previous;
+        } else {
+            app->count--;
+        }
+        return FALSE;
+    }
+    return TRUE;
+}
+
+// Takes every record out first so the file is rewritten once.
+gboolean json_delete_algos(AppData *app, const int *ids, int count) {
+    Algorithm *removed = g_new(Algorithm, MAX(count, 1));
+    int *removed_at = g_new(int, MAX(count, 1));
+    int removed_count = 0;
+    
+    for (int i = 0; i < count; i++) {
+        int index = find_algo_index(app, ids[i]);
+        if (index < 0) continue;
+        
+        removed[removed_count] = app->algos[index];
+        removed_at[removed_count] = index;
+        removed_count++;
+        remove_algo_at(app, index);
+    }
+    
+    gboolean ok = removed_count == 0 || save_to_file(app);
+    if (!ok) {
+        for (int i = removed_count - 1; i >= 0; i--) {
+            insert_algo_at(app, removed_at[i], &removed[i]);
+        }
+    }
+    
+    g_free(removed_at);
+    g_free(removed);
+    return ok;
+}
+
+gboolean json_get_algo(AppData *app, int id, Algorithm *out) {
+    int index = find_algo_index(app, id);
+    if (index < 0) return FALSE;
+    
+    *out = app->algos[index];
+    return TRUE;
+}
+
+// The file keeps no order of its own, so each page takes the n lowest ids past the cursor.
+int json_page(AppData *app, const char *type, gint64 *cursor, int n, Algorithm *out) {
+    SearchHit *heap = g_new(SearchHit, n);
+    int *slots = g_new(int, n);
+    int size = 0;
+    
+    for (int i = 0; i < app->count; i++) {
+        const Algorithm *algo = &app->algos[i];
+        if (algo->id <= *cursor || (type && strcmp(algo->type, type) != 0)) continue;
+        
+        int slot = push_hit(heap, &size, n, 0, algo->id);
+        if (slot >= 0) slots[slot] = i;
+    }
+    
+    int count = size;
+    for (int i = count - 1; i >= 0; i--) {
+        out[i] = app->algos[slots[pop_hit(heap, &size).slot]];
+    }
+    if (count > 0) *cursor = out[count - 1].id;
+    
+    g_free(slots);
+    g_free(heap);
+    return count;
+}
+
+int json_search(AppData *app, const SearchPattern *pattern, const char *type,
+                int k, Algorithm *out, int *scores) {
+    SearchHit *heap = g_new(SearchHit, k);
+    int *slots = g_new(int, k);
+    int size = 0;
+    
+    for (int i = 0; i < app->count; i++) {
+        int score = filtered_score(pattern, type, &app->algos[i]);
+        if (score == 0) continue;
+        
+        int slot = push_hit(heap, &size, k, score, app->algos[i].id);
+        if (slot >= 0) slots[slot] = i;
+    }
+    
+    int count = size;
+    for (int i = count - 1; i >= 0; i--) {
+        SearchHit hit = pop_hit(heap, &size);
+        out[i] = app->algos[slots[hit.slot]];
+        scores[i] = hit.score;
+    }
+    
+    g_free(slots);
+    g_free(heap);
+    return count;
+}
+
+gboolean json_find_pattern(AppData *app, const char *key, int exclude_id, Algorithm *out) {
+    char other[22];
+    for (int i = 0; i < app->count; i++) {
+        algo_pattern_key(&app->algos[i], other);
+        if (app->algos[i].id != exclude_id && strcmp(other, key) == 0) {
+            *out = app->algos[i];
+            return TRUE;
+        }
+    }
+    return FALSE;
+}
+
+const StorageBackend json_backend = {
+    json_open, sync_from_file, json_save_algo, json_delete_algos,
+    json_get_algo, json_page, json_search, json_find_pattern
+};
+
+#define ALGO_COLUMNS "id, name, type, formula, top_layer, side_front, side_right, side_back, side_left"
+
+const char *sqlite_schema =
+    "PRAGMA journal_mode=WAL;"
+    "PRAGMA synchronous=NORMAL;"
+    "CREATE TABLE IF NOT EXISTS algorithms ("
+    "  id INTEGER PRIMARY KEY,"
+    "  name TEXT NOT NULL,"
+    "  type TEXT NOT NULL,"
+    "  formula TEXT NOT NULL,"
+    "  top_layer TEXT NOT NULL,"
+    "  side_front TEXT NOT NULL,"
+    "  side_right TEXT NOT NULL,"
+    "  side_back TEXT NOT NULL,"
+    "  side_left TEXT NOT NULL,"
+    "  pattern_key TEXT NOT NULL);"
+    "CREATE INDEX IF NOT EXISTS algorithms_type ON algorithms(type);"
+    "CREATE INDEX IF NOT EXISTS algorithms_pattern ON algorithms(pattern_key);";
+
+/*
+ * Trigram full-text index over the searchable columns, kept in step by
+ * triggers. It needs FTS5 with the trigram tokenizer; without it, search
+ * falls back to a full scan.
+ */
+const char *sqlite_fts_schema =
+    "CREATE VIRTUAL TABLE algorithms_fts USING fts5("
+    "  name, type, formula, content='algorithms', content_rowid='id', tokenize='trigram');"
+    "CREATE TRIGGER algorithms_ai AFTER INSERT ON algorithms BEGIN"
+    "  INSERT INTO algorithms_fts(rowid, name, type, formula)"
+    "  VALUES (new.id, new.name, new.type, new.formula);"
+    "END;"
+    "CREATE TRIGGER algorithms_ad AFTER DELETE ON algorithms BEGIN"
+    "  INSERT INTO algorithms_fts(algorithms_fts, rowid, name, type, formula)"
+    "  VALUES ('delete', old.id, old.name, old.type, old.formula);"
+    "END;"
+    "CREATE TRIGGER algorithms_au AFTER UPDATE ON algorithms BEGIN"
+    "  INSERT INTO algorithms_fts(algorithms_fts, rowid, name, type, formula)"
+    "  VALUES ('delete', old.id, old.name, old.type, old.formula);"
+    "  INSERT INTO algorithms_fts(rowid, name, type, formula)"
+    "  VALUES (new.id, new.name, new.type, new.formula);"
+    "END;"
+    "INSERT INTO algorithms_fts(algorithms_fts) VALUES ('rebuild');";
+
+gboolean sqlite_write_algo(sqlite3_stmt *stmt, Algorithm *algo) {
+    char top[10], front[4], right[4], back[4], left[4], key[22];
+    snprintf(top, sizeof(top), "%.9s", algo->top_layer);
+    snprintf(front, sizeof(front), "%.3s", algo->side_front);
+    snprintf(right, sizeof(right), "%.3s", algo->side_right);
+    snprintf(back, sizeof(back), "%.3s", algo->side_back);
+    snprintf(left, sizeof(left), "%.3s", algo->side_left);
+    algo_pattern_key(algo, key);
+    
+    sqlite3_reset(stmt);
+    sqlite3_bind_int(stmt, 1, algo->id);
+    sqlite3_bind_text(stmt, 2, algo->name, -1, SQLITE_TRANSIENT);
+    sqlite3_bind_text(stmt, 3, algo->type, -1, SQLITE_TRANSIENT);
+    sqlite3_bind_text(stmt, 4, algo->formula, -1, SQLITE_TRANSIENT);
+    sqlite3_bind_text(stmt, 5, top, -1, SQLITE_TRANSIENT);
+    sqlite3_bind_text(stmt, 6, front, -1, SQLITE_TRANSIENT);
+    sqlite3_bind_text(stmt, 7, right, -1, SQLITE_TRANSIENT);
+    sqlite3_bind_text(stmt, 8, back, -1, SQLITE_TRANSIENT);
+    sqlite3_bind_text(stmt, 9, left, -1, SQLITE_TRANSIENT);
+    sqlite3_bind_text(stmt, 10, key, -1, SQLITE_TRANSIENT);
+    
+    if (sqlite3_step(stmt) != SQLITE_DONE) {
+        return FALSE;
+    }
+    algo->sync_hash = algo_content_hash(algo);
+    return TRUE;
+}
+
+sqlite3_stmt *sqlite_prepare_upsert(sqlite3 *db) {
+    sqlite3_stmt *stmt = NULL;
+    sqlite3_prepare_v2(db,
+        "INSERT INTO algorithms (" ALGO_COLUMNS ", pattern_key)"
+        " VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?)"
+        " ON CONFLICT(id) DO UPDATE SET name = excluded.name, type = excluded.type,"
+        "  formula = excluded.formula, top_layer = excluded.top_layer,"
+        "  side_front = excluded.side_front, side_right = excluded.side_right,"
+        "  side_back = excluded.side_back, side_left = excluded.side_left,"
+        "  pattern_key = excluded.pattern_key",
+        -1, &stmt, NULL);
+    return stmt;
+}
+
+void copy_column(sqlite3_stmt *stmt, int col, char *dst, int size) {
+    const char *text = (const char *)sqlite3_column_text(stmt, col);
+    if (text) {
+        memcpy(dst, text, MIN((int)strlen(text), size));
+    }
+}
+
+// Reads a row selected as ALGO_COLUMNS.
+void sqlite_read_algo(sqlite3_stmt *stmt, Algorithm *algo) {
+    memset(algo, 0, sizeof(Algorithm));
+    algo->id = sqlite3_column_int(stmt, 0);
+    copy_column(stmt, 1, algo->name, 255);
+    copy_column(stmt, 2, algo->type, 63);
+    copy_column(stmt, 3, algo->formula, 1023);
+    copy_column(stmt, 4, algo->top_layer, 9);
+    copy_column(stmt, 5, algo->side_front, 3);
+    copy_column(stmt, 6, algo->side_right, 3);
+    copy_column(stmt, 7, algo->side_back, 3);
+    copy_column(stmt, 8, algo->side_left, 3);
+    algo->sync_hash = algo_content_hash(algo);
+}
+
+int sqlite_user_version(sqlite3 *db) {
+    sqlite3_stmt *stmt;
+    int version = -1;
+    if (sqlite3_prepare_v2(db, "PRAGMA user_version", -1, &stmt, NULL) == SQLITE_OK) {
+        if (sqlite3_step(stmt) == SQLITE_ROW) {
+            version = sqlite3_column_int(stmt, 0);
+        }
+        sqlite3_finalize(stmt);
+    }
+    return version;
+}
+
+gboolean sqlite_table_exists(sqlite3 *db, const char *name) {
+    sqlite3_stmt *stmt;
+    gboolean exists = FALSE;
+    if (sqlite3_prepare_v2(db, "SELECT 1 FROM sqlite_master WHERE name = ?",
+                           -1, &stmt, NULL) == SQLITE_OK) {
+        sqlite3_bind_text(stmt, 1, name, -1, SQLITE_STATIC);
+        exists = sqlite3_step(stmt) == SQLITE_ROW;
+        sqlite3_finalize(stmt);
+    }
+    return exists;
+}
+
+/*
+ * First run only: carry the JSON library over and bump user_version in the
+ * same transaction, so an emptied database is not refilled on a later start.
+ * Records are streamed straight from the parsed file, so MAX_ALGOS does not apply.
+ */
+gboolean sqlite_import_json(AppData *app) {
+    sqlite3_stmt *stmt = sqlite_prepare_upsert(app->db);
+    if (!stmt) return FALSE;
+    
+    JsonParser *parser = json_parser_new();
+    JsonArray *array = read_data_file(parser);
+    guint len = array ? json_array_get_length(array) : 0;
+    
+    gboolean ok = sqlite3_exec(app->db, "BEGIN", NULL, NULL, NULL) == SQLITE_OK;
+    for (guint i = 0; i < len && ok; i++) {
+        JsonObject *obj = json_array_get_object_element(array, i);
+        if (!obj) continue;
+        
+        Algorithm algo;
+        memset(&algo, 0, sizeof(Algorithm));
+        parse_algorithm(obj, &algo);
+        ok = sqlite_write_algo(stmt, &algo);
+    }
+    sqlite3_finalize(stmt);
+    g_object_unref(parser);
+    
+    if (ok) {
+        ok = sqlite3_exec(app->db, "PRAGMA user_version = 1", NULL, NULL, NULL) == SQLITE_OK;
+    }
+    sqlite3_exec(app->db, ok ? "COMMIT" : "ROLLBACK", NULL, NULL, NULL);
+    return ok;
+}
+
+gboolean sqlite_open(AppData *app) {
+    if (sqlite3_open(DB_FILE, &app->db) != SQLITE_OK ||
+        sqlite3_exec(app->db, sqlite_schema, NULL, NULL, NULL) != SQLITE_OK) {
+        g_warning("Cannot open %s: %s", DB_FILE, sqlite3_errmsg(app->db));
+        sqlite3_close(app->db);
+        app->db = NULL;
+        return FALSE;
+    }
+    
+    // Created (and filled from existing rows) in one go the first time it is available.
+    app->fts_ready = sqlite_table_exists(app->db, "algorithms_fts");
+    if (!app->fts_ready) {
+        sqlite3_exec(app->db, "BEGIN", NULL, NULL, NULL);
+        app->fts_ready = sqlite3_exec(app->db, sqlite_fts_schema, NULL, NULL, NULL) == SQLITE_OK;
+        sqlite3_exec(app->db, app->fts_ready ? "COMMIT" : "ROLLBACK", NULL, NULL, NULL);
+        if (!app->fts_ready) {
+            g_message("FTS5 trigram index unavailable, searching %s by full scan", DB_FILE);
+        }
+    }
+    
+    if (sqlite_user_version(app->db) == 0 && !sqlite_import_json(app)) {
+        g_warning("Cannot import %s into %s: %s", DATA_FILE, DB_FILE, sqlite3_errmsg(app->db));
+        sqlite3_close(app->db);
+        app->db = NULL;
+        return FALSE;
+    }
+    return TRUE;
+}
+
+gboolean sqlite_save_algo(AppData *app, Algorithm *algo) {
+    sqlite3_stmt *stmt = sqlite_prepare_upsert(app->db);
+    if (!stmt) return FALSE;
+    
+    // Only the edited row is written; the statement is its own transaction.
+    gboolean ok = sqlite_write_algo(stmt, algo);
+    sqlite3_finalize(stmt);
+    return ok;
+}
+
+// All rows go in one transaction: either the whole batch is deleted or none of it.
+gboolean sqlite_delete_algos(AppData *app, const int *ids, int count) {
+    sqlite3_stmt *stmt;
+    if (sqlite3_prepare_v2(app->db, "DELETE FROM algorithms WHERE id = ?",
+                           -1, &stmt, NULL) != SQLITE_OK) {
+        return FALSE;
+    }
+    
+    gboolean ok = sqlite3_exec(app->db, "BEGIN", NULL, NULL, NULL) == SQLITE_OK;
+    for (int i = 0; i < count && ok; i++) {
+        sqlite3_reset(stmt);
+        sqlite3_bind_int(stmt, 1, ids[i]);
+        ok = sqlite3_step(stmt) == SQLITE_DONE;
+    }
+    sqlite3_finalize(stmt);
+    
+    if (ok) {
+        ok = sqlite3_exec(app->db, "COMMIT", NULL, NULL, NULL) == SQLITE_OK;
+    }
+    if (!ok) {
+        sqlite3_exec(app->db, "ROLLBACK", NULL, NULL, NULL);
+    }
+    return ok;
+}
+
+gboolean sqlite_get_algo(AppData *app, int id, Algorithm *out) {
+    sqlite3_stmt *stmt;
+    if (sqlite3_prepare_v2(app->db, "SELECT " ALGO_COLUMNS " FROM algorithms WHERE id = ?",
+                           -1, &stmt, NULL) != SQLITE_OK) {
+        return FALSE;
+    }
+    
+    sqlite3_bind_int(stmt, 1, id);
+    gboolean found = sqlite3_step(stmt) == SQLITE_ROW;
+    if (found) {
+        sqlite_read_algo(stmt, out);
+    }
+    sqlite3_finalize(stmt);
+    return found;
+}
+
+// Keyset paging: each page is a range scan on the primary key, or on the type index.
+int sqlite_page(AppData *app, const char *type, gint64 *cursor, int n, Algorithm *out) {
+    sqlite3_stmt *stmt;
+    const char *sql = type
+        ? "SELECT " ALGO_COLUMNS " FROM algorithms WHERE type = ?3 AND id > ?1 ORDER BY id LIMIT ?2"
+        : "SELECT " ALGO_COLUMNS " FROM algorithms WHERE id > ?1 ORDER BY id LIMIT ?2";
+    if (sqlite3_prepare_v2(app->db, sql, -1, &stmt, NULL) != SQLITE_OK) {
+        g_warning("Cannot read %s: %s", DB_FILE, sqlite3_errmsg(app->db));
+        return 0;
+    }
+    
+    sqlite3_bind_int64(stmt, 1, *cursor);
+    sqlite3_bind_int(stmt, 2, n);
+    if (type) {
+        sqlite3_bind_text(stmt, 3, type, -1, SQLITE_TRANSIENT);
+    }
+    
+    int count = 0;
+    while (count < n && sqlite3_step(stmt) == SQLITE_ROW) {
+        sqlite_read_algo(stmt, &out[count++]);
+    }
+    sqlite3_finalize(stmt);
+    
+    if (count > 0) *cursor = out[count - 1].id;
+    return count;
+}
+
+// Scores every row the statement returns into the bounded heap; FALSE on a read error.
+gboolean sqlite_collect_hits(sqlite3_stmt *stmt, const SearchPattern *pattern,
+                             SearchHit *heap, int *size, int k, Algorithm *slots) {
+    Algorithm algo;
+    int rc;
+    while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+        sqlite_read_algo(stmt, &algo);
+        int score = algo_search_score(pattern, &algo);
+        if (score == 0) continue;
+        
+        int slot = push_hit(heap, size, k, score, algo.id);
+        if (slot >= 0) slots[slot] = algo;
+    }
+    return rc == SQLITE_DONE;
+}
+
+/*
+ * The trigram index returns every row holding the search text verbatim in
+ * some field. A row it misses needs an edit in each field, so it scores at
+ * most 7 * max_errors + 2 (see algo_search_score). When the indexed hits
+ * fill the result and all beat that bound, or no edits are allowed, the
+ * full scan is skipped.
+ */
+int sqlite_search(AppData *app, const SearchPattern *pattern, const char *type,
+                  int k, Algorithm *out, int *scores) {
+    SearchHit *heap = g_new(SearchHit, k);
+    Algorithm *slots = g_new(Algorithm, k);
+    int size = 0;
+    gboolean complete = FALSE;
+    sqlite3_stmt *stmt;
+    
+    if (app->fts_ready && pattern->length >= 3) {
+        GString *phrase = g_string_new("\"");
+        for (const char *p = pattern->text; *p; p++) {
+            if (*p == '"') g_string_append_c(phrase, '"');
+            g_string_append_c(phrase, *p);
+        }
+        g_string_append_c(phrase, '"');
+        
+        const char *sql = type
+            ? "SELECT a.id, a.name, a.type, a.formula, a.top_layer, a.side_front, a.side_right,"
+              "  a.side_back, a.side_left FROM algorithms_fts JOIN algorithms a"
+              "  ON a.id = algorithms_fts.rowid WHERE algorithms_fts MATCH ?1 AND a.type = ?2"
+            : "SELECT a.id, a.name, a.type, a.formula, a.top_layer, a.side_front, a.side_right,"
+              "  a.side_back, a.side_left FROM algorithms_fts JOIN algorithms a"
+              "  ON a.id = algorithms_fts.rowid WHERE algorithms_fts MATCH ?1";
+        if (sqlite3_prepare_v2(app->db, sql, -1, &stmt, NULL) == SQLITE_OK) {
+            sqlite3_bind_text(stmt, 1, phrase->str, -1, SQLITE_TRANSIENT);
+            if (type) {
+                sqlite3_bind_text(stmt, 2, type, -1, SQLITE_TRANSIENT);
+            }
+            if (sqlite_collect_hits(stmt, pattern, heap, &size, k, slots)) {
+                complete = pattern->max_errors == 0 ||
+                           (size == k && heap[0].score > 7 * pattern->max_errors + 2);
+            }
+            sqlite3_finalize(stmt);
+        }
+        g_string_free(phrase, TRUE);
+    }
+    
+    if (!complete) {
+        size = 0;
+        const char *sql = type
+            ? "SELECT " ALGO_COLUMNS " FROM algorithms WHERE type = ?"
+            : "SELECT " ALGO_COLUMNS " FROM algorithms";
+        if (sqlite3_prepare_v2(app->db, sql, -1, &stmt, NULL) == SQLITE_OK) {
+            if (type) {
+                sqlite3_bind_text(stmt, 1, type, -1, SQLITE_TRANSIENT);
+            }
+            sqlite_collect_hits(stmt, pattern, heap, &size, k, slots);
+            sqlite3_finalize(stmt);
+        }
+    }
+    
+    int count = drain_hits(heap, size, slots, out, scores);
+    g_free(slots);
+    g_free(heap);
+    return count;
+}
+
+char *load_storage_setting(void) {
+    GKeyFile *settings = g_key_file_new();
+    char *backend = NULL;
+    if (g_key_file_load_from_file(settings, SETTINGS_FILE, G_KEY_FILE_NONE, NULL)) {
+        backend = g_key_file_get_string(settings, "storage", "backend", NULL);
+    }
+    g_key_file_free(settings);
+    return backend;
+}
+
+void save_storage_setting(const char *backend) {
+    GKeyFile *settings = g_key_file_new();
+    g_key_file_load_from_file(settings, SETTINGS_FILE, G_KEY_FILE_KEEP_COMMENTS, NULL);
+    g_key_file_set_string(settings, "storage", "backend", backend);
+    g_key_file_save_to_file(settings, SETTINGS_FILE, NULL);
+    g_key_file_free(settings);
+}
+
+// A lookup on the pattern_key index.
+gboolean sqlite_find_pattern(AppData *app, const char *key, int exclude_id, Algorithm *out) {
+    sqlite3_stmt *stmt;
+    if (sqlite3_prepare_v2(app->db,
+            "SELECT " ALGO_COLUMNS " FROM algorithms WHERE pattern_key = ? AND id != ? LIMIT 1",
+            -1, &stmt, NULL) != SQLITE_OK) {
+        return FALSE;
+    }
+    
+    sqlite3_bind_text(stmt, 1, key, -1, SQLITE_TRANSIENT);
+    sqlite3_bind_int(stmt, 2, exclude_id);
+    gboolean found = sqlite3_step(stmt) == SQLITE_ROW;
+    if (found) {
+        sqlite_read_algo(stmt, out);
+    }
+    sqlite3_finalize(stmt);
+    return found;
+}
+
+const StorageBackend sqlite_backend = {
+    sqlite_open, NULL, sqlite_save_algo, sqlite_delete_algos,
+    sqlite_get_algo, sqlite_page, sqlite_search, sqlite_find_pattern
+};
+
+void on_search_changed(GtkEntry *entry, gpointer data) {
+    AppData *app = (AppData *)data;
+    refresh_list(app);
+}
+
+void reset_form(AppData *app) {
+    gtk_entry_set_text(GTK_ENTRY(app->name_entry), "");
+    gtk_combo_box_set_active(GTK_COMBO_BOX(app->type_combo), 0);
+    
+    GtkTextBuffer *buffer = gtk_text_view_get_buffer(GTK_TEXT_VIEW(app->formula_text));
+    gtk_text_buffer_set_text(buffer, "", -1);
+    
+    for (int i = 0; i < 9; i++) {
+        app->current_top[i] = 'Y';
+        set_button_color(app->cube_buttons[i], 'Y');
+    }
+    
+    for (int s = 0; s < 4; s++) {
+        for (int i = 0; i < 3; i++) {
+            app->current_sides[s][i] = 'X';
+            set_button_color(app->side_buttons[s][i], 'X');
+        }
+    }
+    
+    app->editing_id = -1;
+}
+
+void on_save_clicked(GtkWidget *widget, gpointer data) {
+    AppData *app = (AppData *)data;
+    
+    const char *name = gtk_entry_get_text(GTK_ENTRY(app->name_entry));
+    if (strlen(name) == 0) {
+        GtkWidget *dialog = gtk_message_dialog_new(GTK_WINDOW(app->form_window),
+                                                   GTK_DIALOG_MODAL,
+                                                   GTK_MESSAGE_WARNING,
+                                                   GTK_BUTTONS_OK,
+                                                   "Please enter an algorithm name");
+        gtk_dialog_run(GTK_DIALOG(dialog));
+        gtk_widget_destroy(dialog);
+        return;
+    }
+    
+    GtkTextBuffer *buffer = gtk_text_view_get_buffer(GTK_TEXT_VIEW(app->formula_text));
+    GtkTextIter start, end;
+    gtk_text_buffer_get_bounds(buffer, &start, &end);
+    char *formula = gtk_text_buffer_get_text(buffer, &start, &end, FALSE);
+    
+    if (strlen(formula) == 0) {
+        GtkWidget *dialog = gtk_message_dialog_new(GTK_WINDOW(app->form_window),
+                                                   GTK_DIALOG_MODAL,
+                                                   GTK_MESSAGE_WARNING,
+                                                   GTK_BUTTONS_OK,
+                                                   "Please enter a formula");
+        gtk_dialog_run(GTK_DIALOG(dialog));
+        gtk_widget_destroy(dialog);
+        g_free(formula);
+        return;
+    }
+    
+    if (app->backend->sync) app->backend->sync(app);
+    
+    Algorithm algo;
+    gboolean found = TRUE;
+    char old_key[22] = "";
+    if (app->editing_id >= 0) {
+        found = app->backend->get_algo(app, app->editing_id, &algo);
+        if (found) algo_pattern_key(&algo, old_key);
+    } else {
+        memset(&algo, 0, sizeof(Algorithm));
+        algo.id = (int)time(NULL) + rand();
+    }
+    
+    if (found) {
+        strncpy(algo.name, name, 255);
+        algo.name[255] = '\0';
+        
+        const char *type = gtk_combo_box_text_get_active_text(GTK_COMBO_BOX_TEXT(app->type_combo));
+        if (type) {
+            strncpy(algo.type, type, 63);
+            algo.type[63] = '\0';
+        }
+        
+        strncpy(algo.formula, formula, 1023);
+        algo.formula[1023] = '\0';
+        
+        memcpy(algo.top_layer, app->current_top, 9);
+        memcpy(algo.side_front, app->current_sides[0], 3);
+        memcpy(algo.side_right, app->current_sides[1], 3);
+        memcpy(algo.side_back, app->current_sides[2], 3);
+        memcpy(algo.side_left, app->current_sides[3], 3);
+        
+        // Marking a pattern that another entry already has is usually a slip.
+        char key[22];
+        Algorithm other;
+        algo_pattern_key(&algo, key);
+        if (strcmp(key, old_key) != 0 && strcmp(key, BLANK_PATTERN_KEY) != 0 &&
+            app->backend->find_pattern(app, key, algo.id, &other)) {
+            GtkWidget *dialog = gtk_message_dialog_new(GTK_WINDOW(app->form_window),
+                                                       GTK_DIALOG_MODAL,
+                                                       GTK_MESSAGE_QUESTION,
+                                                       GTK_BUTTONS_YES_NO,
+                                                       "\"%s\" (%s) already has this cube pattern. Save anyway?",
+                                                       other.name, other.type);
+            int response = gtk_dialog_run(GTK_DIALOG(dialog));
+            gtk_widget_destroy(dialog);
+            if (response != GTK_RESPONSE_YES) {
+                g_free(formula);
+                return;
+            }
+        }
+        
+        if (!app->backend->save_algo(app, &algo)) {
+            GtkWidget *dialog = gtk_message_dialog_new(GTK_WINDOW(app->form_window),
+                                                       GTK_DIALOG_MODAL,
+                                                       GTK_MESSAGE_ERROR,
+                                                       GTK_BUTTONS_OK,
+                                                       "Could not save the algorithm");
+            if (app->rows_not_loaded > 0) {
+                gtk_message_dialog_format_secondary_text(GTK_MESSAGE_DIALOG(dialog),
+                    "%s has %d more entries than can be loaded; saving is disabled "
+                    "so they are not lost.", DATA_FILE, app->rows_not_loaded);
+            } else if (app->backend == &json_backend && app->count >= MAX_ALGOS) {
+                gtk_message_dialog_format_secondary_text(GTK_MESSAGE_DIALOG(dialog),
+                    "%s holds at most %d algorithms; start with --sqlite for a larger library.",
+                    DATA_FILE, MAX_ALGOS);
+            }
+            gtk_dialog_run(GTK_DIALOG(dialog));
+            gtk_widget_destroy(dialog);
+            g_free(formula);
+            return;
+        }
+        update_list_row(app, &algo);
+    }
+    
+    g_free(formula);
+    gtk_widget_hide(app->form_window);
+}
+
+void on_form_hidden(GtkWidget *widget, gpointer data) {
+    AppData *app = (AppData *)data;
+    app->editing_id = -1;
+    
+    // Outside changes to the record that was open were held back; pick them up now.
+    if (app->backend->sync) app->backend->sync(app);
+}
+
+void on_add_clicked(GtkWidget *widget, gpointer data) {
+    AppData *app = (AppData *)data;
+    reset_form(app);
+    gtk_window_set_title(GTK_WINDOW(app->form_window), "Add New Algorithm");
+    gtk_widget_show_all(app->form_window);
+}
+
+void on_edit_clicked(GtkWidget *widget, gpointer data) {
+    AppData *app = (AppData *)data;
+    
+    GtkTreeSelection *selection = gtk_tree_view_get_selection(GTK_TREE_VIEW(app->list_view));
+    GtkTreeIter iter;
+    GtkTreeModel *model;
+    
+    if (gtk_tree_selection_get_selected(selection, &model, &iter)) {
+        int id;
+        gtk_tree_model_get(model, &iter, 3, &id, -1);
+        
+        // Fill the form from the current file contents, not a stale copy.
+        if (app->backend->sync) app->backend->sync(app);
+        
+        Algorithm stored;
+        if (app->backend->get_algo(app, id, &stored)) {
+            const Algorithm *algo = &stored;
+            app->editing_id = id;
+            gtk_entry_set_text(GTK_ENTRY(app->name_entry), algo->name);
+            
+            const char *types[] = {"OLL", "PLL", "F2L", "ZBLL", "COLL", "Other"};
+            for (int i = 0; i < 6; i++) {
+                if (strcmp(algo->type, types[i]) == 0) {
+                    gtk_combo_box_set_active(GTK_COMBO_BOX(app->type_combo), i);
+                    break;
+                }
+            }
+            
+            GtkTextBuffer *buffer = gtk_text_view_get_buffer(GTK_TEXT_VIEW(app->formula_text));
+            gtk_text_buffer_set_text(buffer, algo->formula, -1);
+            
+            memcpy(app->current_top, algo->top_layer, 9);
+            memcpy(app->current_sides[0], algo->side_front, 3);
+            memcpy(app->current_sides[1], algo->side_right, 3);
+            memcpy(app->current_sides[2], algo->side_back, 3);
+            memcpy(app->current_sides[3], algo->side_left, 3);
+            
+            for (int i = 0; i < 9; i++) {
+                set_button_color(app->cube_buttons[i], app->current_top[i]);
+            }
+            
+            for (int s = 0; s < 4; s++) {
+                for (int i = 0; i < 3; i++) {
+                    set_button_color(app->side_buttons[s][i], app->current_sides[s][i]);
+                }
+            }
+            
+            gtk_window_set_title(GTK_WINDOW(app->form_window), "Edit Algorithm");
+            gtk_widget_show_all(app->form_window);
+        }
+    }
+}
+
+void on_delete_clicked(GtkWidget *widget, gpointer data) {
+    AppData *app = (AppData *)data;
+    
+    GtkTreeSelection *selection = gtk_tree_view_get_selection(GTK_TREE_VIEW(app->list_view));
+    GtkTreeIter iter;
+    GtkTreeModel *model;
+    
+    if (gtk_tree_selection_get_selected(selection, &model, &iter)) {
+        int id;
+        gtk_tree_model_get(model, &iter, 3, &id, -1);
+        
+        GtkWidget *dialog = gtk_message_dialog_new(GTK_WINDOW(app->window),
+                                                   GTK_DIALOG_MODAL,
+                                                   GTK_MESSAGE_QUESTION,
+                                                   GTK_BUTTONS_YES_NO,
+                                                   "Delete this algorithm?");
+        int response = gtk_dialog_run(GTK_DIALOG(dialog));
+        gtk_widget_destroy(dialog);
+        
+        if (response == GTK_RESPONSE_YES) {
+            if (app->backend->sync) app->backend->sync(app);
+            
+            if (!app->backend->delete_algos(app, &id, 1)) {
+                dialog = gtk_message_dialog_new(GTK_WINDOW(app->window),
+                                                GTK_DIALOG_MODAL,
+                                                GTK_MESSAGE_ERROR,
+                                                GTK_BUTTONS_OK,
+                                                "Could not delete the algorithm");
+                gtk_dialog_run(GTK_DIALOG(dialog));
+                gtk_widget_destroy(dialog);
+                return;
+            }
+            remove_list_row(app, id);
+        }
+    }
+}
+
+void fill_sticker(cairo_t *cr, char color, double x, double y, double w, double h) {
+    GdkRGBA rgba;
+    gdk_rgba_parse(&rgba, sticker_hex(color));
+    
+    cairo_rectangle(cr, x, y, w, h);
+    cairo_set_source_rgb(cr, rgba.red, rgba.green, rgba.blue);
+    cairo_fill_preserve(cr);
+    cairo_set_source_rgb(cr, 0x37 / 255.0, 0x41 / 255.0, 0x51 / 255.0);
+    cairo_set_line_width(cr, 0.75);
+    cairo_stroke(cr);
+}
+
+// Same layout as the form: back strip above the top face, front below, left and right beside it.
+void draw_pattern_diagram(cairo_t *cr, const Algorithm *algo, double x, double y, double size) {
+    double strip = size / 11.0;
+    double s = (size - 2 * strip) / 3.0;
+    double top_x = x + strip;
+    double top_y = y + strip;
+    
+    for (int i = 0; i < 9; i++) {
+        fill_sticker(cr, algo->top_layer[i], top_x + (i % 3) * s, top_y + (i / 3) * s, s, s);
+    }
+    
+    for (int i = 0; i < 3; i++) {
+        fill_sticker(cr, algo->side_back[i], top_x + i * s, y, s, strip);
+        fill_sticker(cr, algo->side_front[i], top_x + i * s, top_y + 3 * s, s, strip);
+        fill_sticker(cr, algo->side_left[i], x, top_y + i * s, strip, s);
+        fill_sticker(cr, algo->side_right[i], top_x + 3 * s, top_y + i * s, strip, s);
+    }
+}
+
+// Word-wraps text into at most max_lines lines of the given width.
+void show_wrapped_text(cairo_t *cr, const char *text, double x, double y,
+                       double width, double line_height, int max_lines) {
+    char line[1024] = "";
+    int lines = 0;
+    
+    char **words = g_strsplit_set(text, " \t\n", -1);
+    for (int i = 0; words[i] && lines < max_lines; i++) {
+        if (words[i][0] == '\0') continue;
+        
+        char candidate[1024];
+        snprintf(candidate, sizeof(candidate), "%s%s%s", line, line[0] ? " " : "", words[i]);
+        
+        cairo_text_extents_t extents;
+        cairo_text_extents(cr, candidate, &extents);
+        if (extents.x_advance > width && line[0]) {
+            cairo_move_to(cr, x, y + lines * line_height);
+            cairo_show_text(cr, line);
+            lines++;
+            snprintf(line, sizeof(line), "%s", words[i]);
+        } else {
+            snprintf(line, sizeof(line), "%s", candidate);
+        }
+    }
+    
+    if (line[0] && lines < max_lines) {
+        cairo_move_to(cr, x, y + lines * line_height);
+        cairo_show_text(cr, line);
+    }
+    g_strfreev(words);
+}
+
+void draw_sheet_page(cairo_t *cr, const ExportJob *job, int page) {
+    int per_page = SHEET_COLS * SHEET_ROWS;
+    double cell_w = (SHEET_WIDTH - 2 * SHEET_MARGIN) / SHEET_COLS;
+    double cell_h = (SHEET_HEIGHT - 2 * SHEET_MARGIN) / SHEET_ROWS;
+    double diagram = cell_h * 0.55;
+    
+    cairo_set_source_rgb(cr, 1, 1, 1);
+    cairo_paint(cr);
+    
+    for (int slot = 0; slot < per_page; slot++) {
+        int index = page * per_page + slot;
+        if (index >= job->count) break;
+        
+        const Algorithm *algo = &job->algos[index];
+        double x = SHEET_MARGIN + (slot % SHEET_COLS) * cell_w;
+        double y = SHEET_MARGIN + (slot / SHEET_COLS) * cell_h;
+        
+        cairo_save(cr);
+        cairo_rectangle(cr, x, y, cell_w, cell_h);
+        cairo_clip(cr);
+        
+        draw_pattern_diagram(cr, algo, x + (cell_w - diagram) / 2, y + 4, diagram);
+        
+        char title[512];
+        snprintf(title, sizeof(title), "%s (%s)", algo->name, algo->type);
+        cairo_set_source_rgb(cr, 0, 0, 0);
+        cairo_select_font_face(cr, "Sans", CAIRO_FONT_SLANT_NORMAL, CAIRO_FONT_WEIGHT_BOLD);
+        cairo_set_font_size(cr, 9);
+        show_wrapped_text(cr, title, x + 4, y + diagram + 18, cell_w - 8, 11, 1);
+        
+        cairo_select_font_face(cr, "Sans", CAIRO_FONT_SLANT_NORMAL, CAIRO_FONT_WEIGHT_NORMAL);
+        cairo_set_font_size(cr, 7.5);
+        show_wrapped_text(cr, algo->formula, x + 4, y + diagram + 30, cell_w - 8, 9.5,
+                          (int)((cell_h - diagram - 30) / 9.5));
+        cairo_restore(cr);
+    }
+}
+
+// A PDF or a single page goes to <base>.<ext>; more pages go to <base>-001.<ext> and on.
+char *sheet_page_path(const ExportJob *job, int page) {
+    if (job->page_count == 1 || job->format == EXPORT_PDF) {
+        return g_strdup_printf("%s.%s", job->path_base, job->extension);
+    }
+    return g_strdup_printf("%s-%03d.%s", job->path_base, page + 1, job->extension);
+}
+
+/*
+ * Thread pool worker: draws one page into a surface of its own, so pages
+ * never share cairo state. PNG and SVG pages go straight to their own file;
+ * PDF pages are recorded and replayed in order by export_cheat_sheet.
+ */
+void render_sheet_page(gpointer page_data, gpointer job_data) {
+    ExportJob *job = (ExportJob *)job_data;
+    int page = GPOINTER_TO_INT(page_data) - 1;
+    cairo_surface_t *surface;
+    char *path = NULL;
+    
+    if (job->format == EXPORT_PNG) {
+        surface = cairo_image_surface_create(CAIRO_FORMAT_RGB24,
+                                             (int)(SHEET_WIDTH * PNG_SCALE),
+                                             (int)(SHEET_HEIGHT * PNG_SCALE));
+    } else if (job->format == EXPORT_SVG) {
+        path = sheet_page_path(job, page);
+        surface = cairo_svg_surface_create(path, SHEET_WIDTH, SHEET_HEIGHT);
+    } else {
+        cairo_rectangle_t extents = {0, 0, SHEET_WIDTH, SHEET_HEIGHT};
+        surface = cairo_recording_surface_create(CAIRO_CONTENT_COLOR_ALPHA, &extents);
+    }
+    
+    cairo_t *cr = cairo_create(surface);
+    if (job->format == EXPORT_PNG) {
+        cairo_scale(cr, PNG_SCALE, PNG_SCALE);
+    }
+    draw_sheet_page(cr, job, page);
+    cairo_destroy(cr);
+    
+    if (job->format == EXPORT_PNG) {
+        path = sheet_page_path(job, page);
+        if (cairo_surface_write_to_png(surface, path) != CAIRO_STATUS_SUCCESS) {
+            g_atomic_int_set(&job->failed, TRUE);
+        }
+    }
+    
+    if (job->format == EXPORT_PDF) {
+        job->pages[page] = surface;
+    } else {
+        cairo_surface_finish(surface);
+        if (cairo_surface_status(surface) != CAIRO_STATUS_SUCCESS) {
+            g_atomic_int_set(&job->failed, TRUE);
+        }
+        cairo_surface_destroy(surface);
+    }
+    g_free(path);
+}
+
+gboolean export_cheat_sheet(ExportJob *job) {
+    job->pages = g_new0(cairo_surface_t *, job->page_count);
+    
+    GThreadPool *pool = g_thread_pool_new(render_sheet_page, job,
+                                          (int)g_get_num_processors(), FALSE, NULL);
+    for (int page = 0; page < job->page_count; page++) {
+        g_thread_pool_push(pool, GINT_TO_POINTER(page + 1), NULL);
+    }
+    g_thread_pool_free(pool, FALSE, TRUE);
+    
+    if (job->format == EXPORT_PDF) {
+        char *path = sheet_page_path(job, 0);
+        cairo_surface_t *pdf = cairo_pdf_surface_create(path, SHEET_WIDTH, SHEET_HEIGHT);
+        cairo_t *cr = cairo_create(pdf);
+        
+        for (int page = 0; page < job->page_count; page++) {
+            cairo_set_source_surface(cr, job->pages[page], 0, 0);
+            cairo_paint(cr);
+            cairo_show_page(cr);
+            cairo_surface_destroy(job->pages[page]);
+        }
+        
+        cairo_destroy(cr);
+        cairo_surface_finish(pdf);
+        if (cairo_surface_status(pdf) != CAIRO_STATUS_SUCCESS) {
+            job->failed = TRUE;
+        }
+        cairo_surface_destroy(pdf);
+        g_free(path);
+    }
+    
+    g_free(job->pages);
+    return !job->failed;
+}
+
+void free_export_job(ExportJob *job) {
+    g_free(job->algos);
+    g_free(job->path_base);
+    g_free(job);
+}
+
+/*
+ * The chooser only confirmed overwriting the name that was typed; numbered
+ * pages, or an extension added to a bare name, can still replace other files.
+ */
+gboolean confirm_export_overwrite(GtkWidget *parent, const ExportJob *job, const char *chosen) {
+    int files = job->format == EXPORT_PDF ? 1 : job->page_count;
+    int existing = 0;
+    GString *names = g_string_new(NULL);
+    
+    for (int page = 0; page < files; page++) {
+        char *path = sheet_page_path(job, page);
+        if (strcmp(path, chosen) != 0 && g_file_test(path, G_FILE_TEST_EXISTS)) {
+            if (existing < 5) {
+                char *name = g_path_get_basename(path);
+                g_string_append_printf(names, "\n• %s", name);
+                g_free(name);
+            }
+            existing++;
+        }
+        g_free(path);
+    }
+    if (existing > 5) {
+        g_string_append_printf(names, "\n… and %d more", existing - 5);
+    }
+    
+    int response = GTK_RESPONSE_YES;
+    if (existing > 0) {
+        GtkWidget *dialog = gtk_message_dialog_new(GTK_WINDOW(parent),
+                                                   GTK_DIALOG_MODAL,
+                                                   GTK_MESSAGE_QUESTION,
+                                                   GTK_BUTTONS_YES_NO,
+                                                   "%d file(s) already exist and will be replaced:%s",
+                                                   existing, names->str);
+        response = gtk_dialog_run(GTK_DIALOG(dialog));
+        gtk_widget_destroy(dialog);
+    }
+    
+    g_string_free(names, TRUE);
+    return response == GTK_RESPONSE_YES;
+}
+
+// Back on the main loop once the export thread is done.
+gboolean on_export_finished(gpointer data) {
+    ExportJob *job = (ExportJob *)data;
+    
+    gtk_widget_set_sensitive(job->button, TRUE);
+    
+    GtkWidget *dialog;
+    if (!job->failed) {
+        dialog = gtk_message_dialog_new(GTK_WINDOW(job->window),
+                                        GTK_DIALOG_MODAL,
+                                        GTK_MESSAGE_INFO,
+                                        GTK_BUTTONS_OK,
+                                        "Exported %d algorithms on %d page(s)",
+                                        job->count, job->page_count);
+    } else {
+        dialog = gtk_message_dialog_new(GTK_WINDOW(job->window),
+                                        GTK_DIALOG_MODAL,
+                                        GTK_MESSAGE_ERROR,
+                                        GTK_BUTTONS_OK,
+                                        "Could not write the cheat sheet");
+    }
+    gtk_dialog_run(GTK_DIALOG(dialog));
+    gtk_widget_destroy(dialog);
+    
+    free_export_job(job);
+    return FALSE;
+}
+
+// Runs the whole export, PDF assembly included, off the GTK main thread.
+gpointer export_thread(gpointer data) {
+    ExportJob *job = (ExportJob *)data;
+    export_cheat_sheet(job);
+    g_idle_add(on_export_finished, job);
+    return NULL;
+}
+
+void on_export_clicked(GtkWidget *widget, gpointer data) {
+    AppData *app = (AppData *)data;
+    ExportJob *job = g_new0(ExportJob, 1);
+    
+    // Every entry matching the current search and type, not just the rows on screen.
+    int capacity = SCAN_PAGE_SIZE;
+    job->algos = g_new(Algorithm, capacity);
+    Algorithm *batch = g_new(Algorithm, SCAN_PAGE_SIZE);
+    gint64 cursor = PAGE_START;
+    int n;
+    do {
+        n = app->backend->page(app, app->type_filter, &cursor, SCAN_PAGE_SIZE, batch);
+        for (int i = 0; i < n; i++) {
+            if (algo_search_score(&app->search, &batch[i]) == 0) continue;
+            if (job->count == capacity) {
+                capacity *= 2;
+                job->algos = g_renew(Algorithm, job->algos, capacity);
+            }
+            job->algos[job->count++] = batch[i];
+        }
+    } while (n == SCAN_PAGE_SIZE);
+    g_free(batch);
+    
+    if (job->count == 0) {
+        GtkWidget *dialog = gtk_message_dialog_new(GTK_WINDOW(app->window),
+                                                   GTK_DIALOG_MODAL,
+                                                   GTK_MESSAGE_INFO,
+                                                   GTK_BUTTONS_OK,
+                                                   "No algorithms match the current search, "
+                                                   "so there is nothing to export");
+        gtk_dialog_run(GTK_DIALOG(dialog));
+        gtk_widget_destroy(dialog);
+        free_export_job(job);
+        return;
+    }
+    
+    GtkWidget *chooser = gtk_file_chooser_dialog_new("Export Cheat Sheet",
+                                                     GTK_WINDOW(app->window),
+                                                     GTK_FILE_CHOOSER_ACTION_SAVE,
+                                                     "Cancel", GTK_RESPONSE_CANCEL,
+                                                     "Export", GTK_RESPONSE_ACCEPT,
+                                                     NULL);
+    gtk_file_chooser_set_current_name(GTK_FILE_CHOOSER(chooser), "cheat_sheet.pdf");
+    gtk_file_chooser_set_do_overwrite_confirmation(GTK_FILE_CHOOSER(chooser), TRUE);
+    
+    if (gtk_dialog_run(GTK_DIALOG(chooser)) != GTK_RESPONSE_ACCEPT) {
+        gtk_widget_destroy(chooser);
+        free_export_job(job);
+        return;
+    }
+    
+    char *filename = gtk_file_chooser_get_filename(GTK_FILE_CHOOSER(chooser));
+    char *chosen = g_strdup(filename);
+    gtk_widget_destroy(chooser);
+    
+    job->format = EXPORT_PDF;
+    job->extension = "pdf";
+    job->button = widget;
+    job->window = app->window;
+    
+    // Match the extension in any case and keep the user's spelling of it.
+    char *dot = strrchr(filename, '.');
+    if (dot && strchr(dot, G_DIR_SEPARATOR)) dot = NULL;
+    if (dot) {
+        const char *ext = dot + 1;
+        if (g_ascii_strcasecmp(ext, "png") == 0) {
+            job->format = EXPORT_PNG;
+        } else if (g_ascii_strcasecmp(ext, "svg") == 0) {
+            job->format = EXPORT_SVG;
+        } else if (g_ascii_strcasecmp(ext, "pdf") != 0) {
+            dot = NULL;
+        }
+    }
+    if (dot) {
+        *dot = '\0';
+        job->extension = dot + 1;
+    }
+    job->path_base = filename;
+    
+    int per_page = SHEET_COLS * SHEET_ROWS;
+    job->page_count = (job->count + per_page - 1) / per_page;
+    
+    gboolean confirmed = confirm_export_overwrite(app->window, job, chosen);
+    g_free(chosen);
+    if (!confirmed) {
+        free_export_job(job);
+        return;
+    }
+    
+    gtk_widget_set_sensitive(widget, FALSE);
+    g_thread_unref(g_thread_new("export", export_thread, job));
+}
+
+// Outer faces first, then wide turns (same index + 6), slices and rotations.
+const MoveSpec move_specs[] = {
+    {'R', {1, 0, 0}, 1, 1},  {'L', {-1, 0, 0}, 1, 1}, {'U', {0, 1, 0}, 1, 1},
+    {'D', {0, -1, 0}, 1, 1}, {'F', {0, 0, 1}, 1, 1},  {'B', {0, 0, -1}, 1, 1},
+    {'r', {1, 0, 0}, 0, 1},  {'l', {-1, 0, 0}, 0, 1}, {'u', {0, 1, 0}, 0, 1},
+    {'d', {0, -1, 0}, 0, 1}, {'f', {0, 0, 1}, 0, 1},  {'b', {0, 0, -1}, 0, 1},
+    {'M', {-1, 0, 0}, 0, 0}, {'E', {0, -1, 0}, 0, 0}, {'S', {0, 0, 1}, 0, 0},
+    {'x', {1, 0, 0}, -1, 1}, {'y', {0, 1, 0}, -1, 1}, {'z', {0, 0, 1}, -1, 1},
+};
+
+#define MOVE_COUNT ((int)G_N_ELEMENTS(move_specs))
+#define MOVE_U 2
+
+int facelet_pos[CUBE_FACELETS][3];
+int facelet_normal[CUBE_FACELETS][3];
+CubeState cube_moves[MOVE_COUNT];
+CubeState cube_rotations[24];
+gboolean cube_ready = FALSE;
+
+int dot3(const int *a, const int *b) {
+    return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+}
+
+// Quarter turn clockwise as seen from the axis: v' = (k.v)k - k x v
+void rotate3(const int *k, const int *v, int *out) {
+    int cross[3] = {
+        k[1] * v[2] - k[2] * v[1],
+        k[2] * v[0] - k[0] * v[2],
+        k[0] * v[1] - k[1] * v[0]
+    };
+    int d = dot3(k, v);
+    for (int i = 0; i < 3; i++) {
+        out[i] = d * k[i] - cross[i];
+    }
+}
+
+int facelet_index(const int *pos, const int *normal) {
+    for (int i = 0; i < CUBE_FACELETS; i++) {
+        if (memcmp(facelet_pos[i], pos, sizeof(int) * 3) == 0 &&
+            memcmp(facelet_normal[i], normal, sizeof(int) * 3) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+void cube_identity(CubeState *state) {
+    for (int i = 0; i < CUBE_FACELETS; i++) {
+        state->f[i] = (guchar)i;
+    }
 }
 
-void load_from_file(AppData *app) {
-    if (!g_file_test(DATA_FILE, G_FILE_TEST_EXISTS)) {
-        return;
+// Applies move after state: the facelet now at p is whatever move brought there.
+void cube_apply(CubeState *state, const CubeState *move) {
+    CubeState old = *state;
+    for (int i = 0; i < CUBE_FACELETS; i++) {
+        state->f[i] = old.f[move->f[i]];
+    }
+}
+
+gboolean cube_centers_solved(const CubeState *state) {
+    for (int face = 0; face < 6; face++) {
+        int center = face * 9 + 4;
+        if (state->f[center] != center) return FALSE;
     }
+    return TRUE;
+}
+
+/*
+ * Builds every move from sticker geometry: each facelet is a cubie position
+ * in {-1,0,1}^3 plus the normal of the face it sits on, and a turn rotates
+ * both for the facelets in the turned layers. Runs once, on the main thread.
+ */
+void init_cube_moves(void) {
+    if (cube_ready) return;
     
-    GError *error = NULL;
-    JsonParser *parser = json_parser_new();
+    const int normals[6][3] = {
+        {0, 1, 0}, {1, 0, 0}, {0, 0, 1}, {0, -1, 0}, {-1, 0, 0}, {0, 0, -1}
+    };
+    int n = 0;
+    for (int face = 0; face < 6; face++) {
+        int axis = normals[face][0] ? 0 : (normals[face][1] ? 1 : 2);
+        int u = (axis + 1) % 3;
+        int v = (axis + 2) % 3;
+        for (int a = -1; a <= 1; a++) {
+            for (int b = -1; b <= 1; b++) {
+                memcpy(facelet_normal[n], normals[face], sizeof(int) * 3);
+                memcpy(facelet_pos[n], normals[face], sizeof(int) * 3);
+                facelet_pos[n][u] = a;
+                facelet_pos[n][v] = b;
+                n++;
+            }
+        }
+    }
     
-    if (!json_parser_load_from_file(parser, DATA_FILE, &error)) {
-        if (error) {
-            g_error_free(error);
+    for (int m = 0; m < MOVE_COUNT; m++) {
+        const MoveSpec *spec = &move_specs[m];
+        cube_identity(&cube_moves[m]);
+        for (int i = 0; i < CUBE_FACELETS; i++) {
+            int depth = dot3(facelet_pos[i], spec->axis);
+            if (depth < spec->lo || depth > spec->hi) continue;
+            
+            int pos[3], normal[3];
+            rotate3(spec->axis, facelet_pos[i], pos);
+            rotate3(spec->axis, facelet_normal[i], normal);
+            cube_moves[m].f[facelet_index(pos, normal)] = (guchar)i;
         }
-        g_object_unref(parser);
-        return;
     }
     
-    JsonNode *root = json_parser_get_root(parser);
-    if (!root || !JSON_NODE_HOLDS_ARRAY(root)) {
-        g_object_unref(parser);
-        return;
+    // The 24 whole-cube orientations: bring each face up, then turn with y.
+    const char *ups[] = {"", "x", "xx", "xxx", "z", "zzz"};
+    int r = 0;
+    for (int i = 0; i < 6; i++) {
+        for (int k = 0; k < 4; k++) {
+            cube_identity(&cube_rotations[r]);
+            for (const char *c = ups[i]; *c; c++) {
+                cube_apply(&cube_rotations[r], &cube_moves[*c == 'x' ? 15 : 17]);
+            }
+            for (int j = 0; j < k; j++) {
+                cube_apply(&cube_rotations[r], &cube_moves[16]);
+            }
+            r++;
+        }
     }
     
-    JsonArray *array = json_node_get_array(root);
-    guint len = json_array_get_length(array);
+    cube_ready = TRUE;
+}
+
+int find_move(char name) {
+    for (int m = 0; m < MOVE_COUNT; m++) {
+        if (move_specs[m].name == name) return m;
+    }
+    return -1;
+}
+
+// Parses standard notation (R U' r2 Rw M x ...); FALSE on anything else.
+gboolean simulate_formula(const char *formula, CubeState *state) {
+    cube_identity(state);
+    gboolean any = FALSE;
     
-    app->count = 0;
-    for (guint i = 0; i < len && app->count < MAX_ALGOS; i++) {
-        JsonObject *obj = json_array_get_object_element(array, i);
-        if (!obj) continue;
-        
-        app->algos[app->count].id = json_object_get_int_member(obj, "id");
-        
-        const char *name = json_object_get_string_member(obj, "name");
-        if (name) strncpy(app->algos[app->count].name, name, 255);
-        
-        const char *type = json_object_get_string_member(obj, "type");
-        if (type) strncpy(app->algos[app->count].type, type, 63);
-        
-        const char *formula = json_object_get_string_member(obj, "formula");
-        if (formula) strncpy(app->algos[app->count].formula, formula, 1023);
-        
-        const char *top = json_object_get_string_member(obj, "top_layer");
-        if (top && strlen(top) >= 9) {
-            memcpy(app->algos[app->count].top_layer, top, 9);
+    const char *p = formula;
+    while (*p) {
+        if (isspace((guchar)*p) || strchr("()[]", *p)) {
+            p++;
+            continue;
         }
         
-        const char *front = json_object_get_string_member(obj, "side_front");
-        if (front && strlen(front) >= 3) {
-            memcpy(app->algos[app->count].side_front, front, 3);
-        }
+        int m = find_move(*p);
+        if (m < 0) return FALSE;
+        p++;
         
-        const char *right = json_object_get_string_member(obj, "side_right");
-        if (right && strlen(right) >= 3) {
-            memcpy(app->algos[app->count].side_right, right, 3);
+        if (*p == 'w' && m < 6) {
+            m += 6;
+            p++;
         }
         
-        const char *back = json_object_get_string_member(obj, "side_back");
-        if (back && strlen(back) >= 3) {
-            memcpy(app->algos[app->count].side_back, back, 3);
+        int turns = 1;
+        gboolean prime = FALSE;
+        for (;;) {
+            if (isdigit((guchar)*p)) {
+                turns = *p - '0';
+                p++;
+            } else if (*p == '\'') {
+                prime = TRUE;
+                p++;
+            } else if (strncmp(p, "\xE2\x80\x99", 3) == 0) {
+                prime = TRUE;
+                p += 3;
+            } else {
+                break;
+            }
         }
+        if (prime) turns = 4 - turns % 4;
         
-        const char *left = json_object_get_string_member(obj, "side_left");
-        if (left && strlen(left) >= 3) {
-            memcpy(app->algos[app->count].side_left, left, 3);
+        for (int t = 0; t < turns % 4; t++) {
+            cube_apply(state, &cube_moves[m]);
         }
-        
-        app->count++;
+        any = TRUE;
     }
-    
-    g_object_unref(parser);
+    return any;
 }
 
-void refresh_list(AppData *app) {
-    gtk_list_store_clear(app->list_store);
+/*
+ * Canonical effect of a formula: undo any net whole-cube rotation, then
+ * take the smallest state over all 16 pre/post AUF combinations so that
+ * U A U' and A land on the same key.
+ */
+gboolean canonical_cube_state(const char *formula, CubeState *out) {
+    CubeState effect;
+    if (!simulate_formula(formula, &effect)) {
+        return FALSE;
+    }
     
-    const char *search_text = gtk_entry_get_text(GTK_ENTRY(app->search_entry));
+    for (int r = 0; r < 24; r++) {
+        CubeState oriented = effect;
+        cube_apply(&oriented, &cube_rotations[r]);
+        if (cube_centers_solved(&oriented)) {
+            effect = oriented;
+            break;
+        }
+    }
     
-    for (int i = 0; i < app->count; i++) {
-        if (strlen(search_text) > 0) {
-            char search_lower[256];
-            strncpy(search_lower, search_text, 255);
-            for (int j = 0; search_lower[j]; j++) {
-                search_lower[j] = tolower(search_lower[j]);
-            }
-            
-            char name_lower[256];
-            strncpy(name_lower, app->algos[i].name, 255);
-            for (int j = 0; name_lower[j]; j++) {
-                name_lower[j] = tolower(name_lower[j]);
-            }
-            
-            if (!strstr(name_lower, search_lower) &&
-                !strstr(app->algos[i].type, search_text) &&
-                !strstr(app->algos[i].formula, search_text)) {
-                continue;
+    CubeState pre;
+    cube_identity(&pre);
+    for (int a = 0; a < 4; a++) {
+        CubeState candidate = pre;
+        cube_apply(&candidate, &effect);
+        for (int b = 0; b < 4; b++) {
+            if ((a == 0 && b == 0) || memcmp(candidate.f, out->f, CUBE_FACELETS) < 0) {
+                *out = candidate;
             }
+            cube_apply(&candidate, &cube_moves[MOVE_U]);
         }
-        
-        GtkTreeIter iter;
-        gtk_list_store_append(app->list_store, &iter);
-        gtk_list_store_set(app->list_store, &iter,
-                          0, app->algos[i].name,
-                          1, app->algos[i].type,
-                          2, app->algos[i].formula,
-                          3, app->algos[i].id,
-                          -1);
+        cube_apply(&pre, &cube_moves[MOVE_U]);
     }
+    return TRUE;
 }
 
-void on_search_changed(GtkEntry *entry, gpointer data) {
-    AppData *app = (AppData *)data;
-    refresh_list(app);
+guint cube_state_hash(gconstpointer key) {
+    return hash_bytes(2166136261u, (const char *)((const CubeState *)key)->f, CUBE_FACELETS);
 }
 
-void reset_form(AppData *app) {
-    gtk_entry_set_text(GTK_ENTRY(app->name_entry), "");
-    gtk_combo_box_set_active(GTK_COMBO_BOX(app->type_combo), 0);
-    
-    GtkTextBuffer *buffer = gtk_text_view_get_buffer(GTK_TEXT_VIEW(app->formula_text));
-    gtk_text_buffer_set_text(buffer, "", -1);
-    
-    for (int i = 0; i < 9; i++) {
-        app->current_top[i] = 'Y';
-        set_button_color(app->cube_buttons[i], 'Y');
-    }
+gboolean cube_state_equal(gconstpointer a, gconstpointer b) {
+    return memcmp(((const CubeState *)a)->f, ((const CubeState *)b)->f, CUBE_FACELETS) == 0;
+}
+
+void scan_duplicate_chunk(gpointer chunk_data, gpointer scan_data) {
+    DuplicateScan *scan = (DuplicateScan *)scan_data;
+    int start = (GPOINTER_TO_INT(chunk_data) - 1) * scan->chunk_size;
+    int end = MIN(start + scan->chunk_size, scan->count);
     
-    for (int s = 0; s < 4; s++) {
-        for (int i = 0; i < 3; i++) {
-            app->current_sides[s][i] = 'X';
-            set_button_color(app->side_buttons[s][i], 'X');
-        }
+    for (int i = start; i < end; i++) {
+        scan->valid[i] = canonical_cube_state(scan->algos[i].formula, &scan->states[i]);
     }
-    
-    app->editing_id = -1;
 }
 
-void on_save_clicked(GtkWidget *widget, gpointer data) {
-    AppData *app = (AppData *)data;
+void simulate_batch(DuplicateScan *scan) {
+    int chunks = MIN(scan->count, (int)g_get_num_processors() * 4);
+    scan->chunk_size = (scan->count + chunks - 1) / chunks;
     
-    const char *name = gtk_entry_get_text(GTK_ENTRY(app->name_entry));
-    if (strlen(name) == 0) {
-        GtkWidget *dialog = gtk_message_dialog_new(GTK_WINDOW(app->form_window),
-                                                   GTK_DIALOG_MODAL,
-                                                   GTK_MESSAGE_WARNING,
-                                                   GTK_BUTTONS_OK,
-                                                   "Please enter an algorithm name");
-        gtk_dialog_run(GTK_DIALOG(dialog));
-        gtk_widget_destroy(dialog);
-        return;
+    GThreadPool *pool = g_thread_pool_new(scan_duplicate_chunk, scan,
+                                          (int)g_get_num_processors(), FALSE, NULL);
+    for (int c = 0; c < chunks; c++) {
+        g_thread_pool_push(pool, GINT_TO_POINTER(c + 1), NULL);
     }
+    g_thread_pool_free(pool, FALSE, TRUE);
+}
+
+void set_duplicate_row(GtkTreeStore *store, GtkTreeIter *iter, const char *name,
+                       const Algorithm *algo, const char *formula) {
+    gtk_tree_store_set(store, iter, 0, name, 1, algo->type, 2, formula, 3, algo->id, -1);
+}
+
+/*
+ * Pages through the whole store, simulating each batch in parallel and
+ * keeping only ids and canonical states, then groups entries with the same
+ * state in a single pass. Fills store with one parent row per group and one
+ * child row per entry, fetched back by id; returns the number of groups.
+ */
+int find_duplicate_groups(AppData *app, GtkTreeStore *store) {
+    init_cube_moves();
     
-    GtkTextBuffer *buffer = gtk_text_view_get_buffer(GTK_TEXT_VIEW(app->formula_text));
-    GtkTextIter start, end;
-    gtk_text_buffer_get_bounds(buffer, &start, &end);
-    char *formula = gtk_text_buffer_get_text(buffer, &start, &end, FALSE);
-    
-    if (strlen(formula) == 0) {
-        GtkWidget *dialog = gtk_message_dialog_new(GTK_WINDOW(app->form_window),
-                                                   GTK_DIALOG_MODAL,
-                                                   GTK_MESSAGE_WARNING,
-                                                   GTK_BUTTONS_OK,
-                                                   "Please enter a formula");
-        gtk_dialog_run(GTK_DIALOG(dialog));
-        gtk_widget_destroy(dialog);
-        g_free(formula);
-        return;
-    }
+    int capacity = SCAN_PAGE_SIZE;
+    int count = 0;
+    int *ids = g_new(int, capacity);
+    CubeState *states = g_new(CubeState, capacity);
+    gboolean *valid = g_new(gboolean, capacity);
+    Algorithm *batch = g_new(Algorithm, SCAN_PAGE_SIZE);
+    gint64 cursor = PAGE_START;
+    int n;
     
-    Algorithm *algo = NULL;
-    if (app->editing_id >= 0) {
-        for (int i = 0; i < app->count; i++) {
-            if (app->algos[i].id == app->editing_id) {
-                algo = &app->algos[i];
-                break;
-            }
+    do {
+        n = app->backend->page(app, NULL, &cursor, SCAN_PAGE_SIZE, batch);
+        if (count + n > capacity) {
+            capacity *= 2;
+            ids = g_renew(int, ids, capacity);
+            states = g_renew(CubeState, states, capacity);
+            valid = g_renew(gboolean, valid, capacity);
         }
-    } else {
-        if (app->count < MAX_ALGOS) {
-            algo = &app->algos[app->count];
-            algo->id = (int)time(NULL) + rand();
-            app->count++;
+        if (n == 0) break;
+        
+        DuplicateScan scan;
+        scan.algos = batch;
+        scan.states = states + count;
+        scan.valid = valid + count;
+        scan.count = n;
+        simulate_batch(&scan);
+        
+        for (int i = 0; i < n; i++) {
+            ids[count + i] = batch[i].id;
         }
+        count += n;
+    } while (n == SCAN_PAGE_SIZE);
+    g_free(batch);
+    
+    // Walk backwards so each group's list comes out in id order.
+    GHashTable *groups = g_hash_table_new_full(cube_state_hash, cube_state_equal,
+                                               NULL, (GDestroyNotify)g_slist_free);
+    for (int i = count - 1; i >= 0; i--) {
+        if (!valid[i]) continue;
+        GSList *members = g_hash_table_lookup(groups, &states[i]);
+        g_hash_table_steal(groups, &states[i]);
+        g_hash_table_insert(groups, &states[i], g_slist_prepend(members, GINT_TO_POINTER(i)));
     }
     
-    if (algo) {
-        strncpy(algo->name, name, 255);
-        algo->name[255] = '\0';
+    int group_count = 0;
+    for (int i = 0; i < count; i++) {
+        if (!valid[i]) continue;
+        GSList *members = g_hash_table_lookup(groups, &states[i]);
+        if (GPOINTER_TO_INT(members->data) != i || !members->next) continue;
         
-        const char *type = gtk_combo_box_text_get_active_text(GTK_COMBO_BOX_TEXT(app->type_combo));
-        if (type) {
-            strncpy(algo->type, type, 63);
-            algo->type[63] = '\0';
-        }
+        GtkTreeIter parent;
+        gtk_tree_store_append(store, &parent, NULL);
+        int shown = 0;
+        Algorithm first;
         
-        strncpy(algo->formula, formula, 1023);
-        algo->formula[1023] = '\0';
+        for (GSList *m = members; m; m = m->next) {
+            Algorithm algo;
+            if (!app->backend->get_algo(app, ids[GPOINTER_TO_INT(m->data)], &algo)) continue;
+            if (shown++ == 0) first = algo;
+            
+            GtkTreeIter child;
+            gtk_tree_store_append(store, &child, &parent);
+            set_duplicate_row(store, &child, algo.name, &algo, algo.formula);
+        }
         
-        memcpy(algo->top_layer, app->current_top, 9);
-        memcpy(algo->side_front, app->current_sides[0], 3);
-        memcpy(algo->side_right, app->current_sides[1], 3);
-        memcpy(algo->side_back, app->current_sides[2], 3);
-        memcpy(algo->side_left, app->current_sides[3], 3);
+        if (shown < 2) {
+            gtk_tree_store_remove(store, &parent);
+            continue;
+        }
         
-        save_to_file(app);
-        refresh_list(app);
+        char label[300];
+        snprintf(label, sizeof(label), "%s (%d entries)", first.name, shown);
+        set_duplicate_row(store, &parent, label, &first, "");
+        group_count++;
     }
     
-    g_free(formula);
-    gtk_widget_hide(app->form_window);
-}
-
-void on_add_clicked(GtkWidget *widget, gpointer data) {
-    AppData *app = (AppData *)data;
-    reset_form(app);
-    gtk_window_set_title(GTK_WINDOW(app->form_window), "Add New Algorithm");
-    gtk_widget_show_all(app->form_window);
+    g_hash_table_destroy(groups);
+    g_free(valid);
+    g_free(states);
+    g_free(ids);
+    return group_count;
 }
 
-void on_edit_clicked(GtkWidget *widget, gpointer data) {
-    AppData *app = (AppData *)data;
+// Keeps the selected entry (or the group's first one) and deletes the rest of its group.
+void merge_duplicate_group(AppData *app, GtkWidget *parent, GtkTreeStore *store, GtkTreeIter *selected) {
+    GtkTreeModel *model = GTK_TREE_MODEL(store);
+    GtkTreeIter group, keep;
     
-    GtkTreeSelection *selection = gtk_tree_view_get_selection(GTK_TREE_VIEW(app->list_view));
-    GtkTreeIter iter;
-    GtkTreeModel *model;
+    if (gtk_tree_store_iter_depth(store, selected) == 0) {
+        group = *selected;
+        if (!gtk_tree_model_iter_children(model, &keep, &group)) return;
+    } else {
+        keep = *selected;
+        gtk_tree_model_iter_parent(model, &group, selected);
+    }
     
-    if (gtk_tree_selection_get_selected(selection, &model, &iter)) {
+    int keep_id;
+    char *keep_name;
+    gtk_tree_model_get(model, &keep, 0, &keep_name, 3, &keep_id, -1);
+    
+    int members = gtk_tree_model_iter_n_children(model, &group);
+    int *ids = g_new(int, members);
+    int id_count = 0;
+    GString *message = g_string_new(NULL);
+    g_string_printf(message, "Keep \"%s\" and delete:\n", keep_name);
+    
+    GtkTreeIter child;
+    gboolean valid = gtk_tree_model_iter_children(model, &child, &group);
+    while (valid) {
         int id;
-        gtk_tree_model_get(model, &iter, 3, &id, -1);
-        
-        Algorithm *algo = NULL;
-        for (int i = 0; i < app->count; i++) {
-            if (app->algos[i].id == id) {
-                algo = &app->algos[i];
-                break;
-            }
+        char *name, *type;
+        gtk_tree_model_get(model, &child, 0, &name, 1, &type, 3, &id, -1);
+        if (id != keep_id) {
+            ids[id_count++] = id;
+            g_string_append_printf(message, "\n• %s (%s)", name, type);
         }
-        
-        if (algo) {
-            app->editing_id = id;
-            gtk_entry_set_text(GTK_ENTRY(app->name_entry), algo->name);
-            
-            const char *types[] = {"OLL", "PLL", "F2L", "ZBLL", "COLL", "Other"};
-            for (int i = 0; i < 6; i++) {
-                if (strcmp(algo->type, types[i]) == 0) {
-                    gtk_combo_box_set_active(GTK_COMBO_BOX(app->type_combo), i);
-                    break;
-                }
-            }
-            
-            GtkTextBuffer *buffer = gtk_text_view_get_buffer(GTK_TEXT_VIEW(app->formula_text));
-            gtk_text_buffer_set_text(buffer, algo->formula, -1);
-            
-            memcpy(app->current_top, algo->top_layer, 9);
-            memcpy(app->current_sides[0], algo->side_front, 3);
-            memcpy(app->current_sides[1], algo->side_right, 3);
-            memcpy(app->current_sides[2], algo->side_back, 3);
-            memcpy(app->current_sides[3], algo->side_left, 3);
-            
-            for (int i = 0; i < 9; i++) {
-                set_button_color(app->cube_buttons[i], app->current_top[i]);
-            }
-            
-            for (int s = 0; s < 4; s++) {
-                for (int i = 0; i < 3; i++) {
-                    set_button_color(app->side_buttons[s][i], app->current_sides[s][i]);
-                }
-            }
-            
-            gtk_window_set_title(GTK_WINDOW(app->form_window), "Edit Algorithm");
-            gtk_widget_show_all(app->form_window);
+        g_free(name);
+        g_free(type);
+        valid = gtk_tree_model_iter_next(model, &child);
+    }
+    g_free(keep_name);
+    
+    GtkWidget *dialog = gtk_message_dialog_new(GTK_WINDOW(parent),
+                                               GTK_DIALOG_MODAL,
+                                               GTK_MESSAGE_QUESTION,
+                                               GTK_BUTTONS_YES_NO,
+                                               "%s", message->str);
+    int response = gtk_dialog_run(GTK_DIALOG(dialog));
+    gtk_widget_destroy(dialog);
+    g_string_free(message, TRUE);
+    
+    if (response != GTK_RESPONSE_YES) {
+        g_free(ids);
+        return;
+    }
+    
+    if (app->backend->sync) app->backend->sync(app);
+    
+    if (!app->backend->delete_algos(app, ids, id_count)) {
+        dialog = gtk_message_dialog_new(GTK_WINDOW(parent),
+                                        GTK_DIALOG_MODAL,
+                                        GTK_MESSAGE_ERROR,
+                                        GTK_BUTTONS_OK,
+                                        "Could not delete the duplicate algorithms");
+        gtk_dialog_run(GTK_DIALOG(dialog));
+        gtk_widget_destroy(dialog);
+    } else {
+        for (int i = 0; i < id_count; i++) {
+            remove_list_row(app, ids[i]);
         }
+        gtk_tree_store_remove(store, &group);
     }
+    
+    g_free(ids);
 }
 
-void on_delete_clicked(GtkWidget *widget, gpointer data) {
+void on_duplicates_clicked(GtkWidget *widget, gpointer data) {
     AppData *app = (AppData *)data;
     
-    GtkTreeSelection *selection = gtk_tree_view_get_selection(GTK_TREE_VIEW(app->list_view));
-    GtkTreeIter iter;
-    GtkTreeModel *model;
+    GtkTreeStore *store = gtk_tree_store_new(4, G_TYPE_STRING, G_TYPE_STRING,
+                                             G_TYPE_STRING, G_TYPE_INT);
+    int group_count = find_duplicate_groups(app, store);
     
-    if (gtk_tree_selection_get_selected(selection, &model, &iter)) {
-        int id;
-        gtk_tree_model_get(model, &iter, 3, &id, -1);
-        
+    if (group_count == 0) {
         GtkWidget *dialog = gtk_message_dialog_new(GTK_WINDOW(app->window),
                                                    GTK_DIALOG_MODAL,
-                                                   GTK_MESSAGE_QUESTION,
-                                                   GTK_BUTTONS_YES_NO,
-                                                   "Delete this algorithm?");
-        int response = gtk_dialog_run(GTK_DIALOG(dialog));
+                                                   GTK_MESSAGE_INFO,
+                                                   GTK_BUTTONS_OK,
+                                                   "No duplicate algorithms found");
+        gtk_dialog_run(GTK_DIALOG(dialog));
         gtk_widget_destroy(dialog);
-        
-        if (response == GTK_RESPONSE_YES) {
-            for (int i = 0; i < app->count; i++) {
-                if (app->algos[i].id == id) {
-                    for (int j = i; j < app->count - 1; j++) {
-                        app->algos[j] = app->algos[j + 1];
-                    }
-                    app->count--;
-                    break;
-                }
-            }
-            save_to_file(app);
-            refresh_list(app);
+        g_object_unref(store);
+        return;
+    }
+    
+    GtkWidget *dialog = gtk_dialog_new_with_buttons("Duplicate Algorithms",
+                                                    GTK_WINDOW(app->window),
+                                                    GTK_DIALOG_MODAL,
+                                                    "Merge Selected Group", GTK_RESPONSE_ACCEPT,
+                                                    "Close", GTK_RESPONSE_CLOSE,
+                                                    NULL);
+    gtk_window_set_default_size(GTK_WINDOW(dialog), 800, 450);
+    
+    GtkWidget *scroll = gtk_scrolled_window_new(NULL, NULL);
+    gtk_scrolled_window_set_policy(GTK_SCROLLED_WINDOW(scroll),
+                                   GTK_POLICY_AUTOMATIC,
+                                   GTK_POLICY_AUTOMATIC);
+    
+    GtkWidget *view = gtk_tree_view_new_with_model(GTK_TREE_MODEL(store));
+    GtkCellRenderer *renderer = gtk_cell_renderer_text_new();
+    gtk_tree_view_append_column(GTK_TREE_VIEW(view),
+        gtk_tree_view_column_new_with_attributes("Name", renderer, "text", 0, NULL));
+    gtk_tree_view_append_column(GTK_TREE_VIEW(view),
+        gtk_tree_view_column_new_with_attributes("Type", renderer, "text", 1, NULL));
+    gtk_tree_view_append_column(GTK_TREE_VIEW(view),
+        gtk_tree_view_column_new_with_attributes("Formula", renderer, "text", 2, NULL));
+    gtk_tree_view_expand_all(GTK_TREE_VIEW(view));
+    
+    gtk_container_add(GTK_CONTAINER(scroll), view);
+    gtk_box_pack_start(GTK_BOX(gtk_dialog_get_content_area(GTK_DIALOG(dialog))), scroll, TRUE, TRUE, 0);
+    gtk_widget_show_all(dialog);
+    
+    while (gtk_dialog_run(GTK_DIALOG(dialog)) == GTK_RESPONSE_ACCEPT) {
+        GtkTreeSelection *selection = gtk_tree_view_get_selection(GTK_TREE_VIEW(view));
+        GtkTreeIter iter;
+        if (gtk_tree_selection_get_selected(selection, NULL, &iter)) {
+            merge_duplicate_group(app, dialog, store, &iter);
         }
     }
+    
+    gtk_widget_destroy(dialog);
+    g_object_unref(store);
 }
 
 void on_reset_colors_clicked(GtkWidget *widget, gpointer data) {
@@ -496,6 +2443,7 @@ void create_form_window(AppData *app) {
     gtk_window_set_transient_for(GTK_WINDOW(app->form_window), GTK_WINDOW(app->window));
     gtk_window_set_modal(GTK_WINDOW(app->form_window), TRUE);
     g_signal_connect(app->form_window, "delete-event", G_CALLBACK(gtk_widget_hide_on_delete), NULL);
+    g_signal_connect(app->form_window, "hide", G_CALLBACK(on_form_hidden), app);
     
  GtkWidget *scroll_window = gtk_scrolled_window_new(NULL, NULL);
     gtk_scrolled_window_set_policy(GTK_SCROLLED_WINDOW(scroll_window),
@@ -673,7 +2621,34 @@ AppData app;
 memset(&app, 0, sizeof(AppData));
 app.editing_id = -1;
 
-load_from_file(&app);
+// The store is an explicit choice: --sqlite or --json switches it and the choice is kept.
+char *stored_backend = load_storage_setting();
+const char *previous_backend = stored_backend ? stored_backend : "json";
+const char *wanted_backend = previous_backend;
+for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--sqlite") == 0) wanted_backend = "sqlite";
+    if (strcmp(argv[i], "--json") == 0) wanted_backend = "json";
+}
+
+app.backend = strcmp(wanted_backend, "sqlite") == 0 ? &sqlite_backend : &json_backend;
+if (!app.backend->open(&app)) {
+    app.backend = &json_backend;
+    app.backend->open(&app);
+}
+
+const char *active_backend = app.backend == &sqlite_backend ? "sqlite" : "json";
+const char *storage_notice = NULL;
+if (strcmp(active_backend, previous_backend) != 0) {
+    save_storage_setting(active_backend);
+    storage_notice = app.backend == &sqlite_backend
+        ? "Your library is now stored in " DB_FILE ". " DATA_FILE " is no longer read "
+          "or updated; start with --json to switch back."
+        : "Your library is now stored in " DATA_FILE " again. Changes made while using "
+          DB_FILE " are not in it; start with --sqlite to switch back.";
+} else if (strcmp(active_backend, wanted_backend) != 0) {
+    storage_notice = "Could not open " DB_FILE "; still using " DATA_FILE ".";
+}
+g_free(stored_backend);
 
 app.window = gtk_window_new(GTK_WINDOW_TOPLEVEL);
 gtk_window_set_title(GTK_WINDOW(app.window), "Cube Algorithm Manager");
@@ -700,6 +2675,18 @@ gtk_entry_set_placeholder_text(GTK_ENTRY(app.search_entry), "🔍 Search algorit
 g_signal_connect(app.search_entry, "changed", G_CALLBACK(on_search_changed), &app);
 gtk_box_pack_start(GTK_BOX(hbox), app.search_entry, TRUE, TRUE, 0);
 
+app.type_filter_combo = gtk_combo_box_text_new();
+gtk_combo_box_text_append_text(GTK_COMBO_BOX_TEXT(app.type_filter_combo), "All types");
+gtk_combo_box_text_append_text(GTK_COMBO_BOX_TEXT(app.type_filter_combo), "OLL");
+gtk_combo_box_text_append_text(GTK_COMBO_BOX_TEXT(app.type_filter_combo), "PLL");
+gtk_combo_box_text_append_text(GTK_COMBO_BOX_TEXT(app.type_filter_combo), "F2L");
+gtk_combo_box_text_append_text(GTK_COMBO_BOX_TEXT(app.type_filter_combo), "ZBLL");
+gtk_combo_box_text_append_text(GTK_COMBO_BOX_TEXT(app.type_filter_combo), "COLL");
+gtk_combo_box_text_append_text(GTK_COMBO_BOX_TEXT(app.type_filter_combo), "Other");
+gtk_combo_box_set_active(GTK_COMBO_BOX(app.type_filter_combo), 0);
+g_signal_connect(app.type_filter_combo, "changed", G_CALLBACK(on_search_changed), &app);
+gtk_box_pack_start(GTK_BOX(hbox), app.type_filter_combo, FALSE, FALSE, 0);
+
 GtkWidget *add_btn = gtk_button_new_with_label("+ Add Algorithm");
 g_signal_connect(add_btn, "clicked", G_CALLBACK(on_add_clicked), &app);
 gtk_box_pack_start(GTK_BOX(hbox), add_btn, FALSE, FALSE, 0);
@@ -712,6 +2699,14 @@ GtkWidget *del_btn = gtk_button_new_with_label("🗑 Delete");
 g_signal_connect(del_btn, "clicked", G_CALLBACK(on_delete_clicked), &app);
 gtk_box_pack_start(GTK_BOX(hbox), del_btn, FALSE, FALSE, 0);
 
+GtkWidget *export_btn = gtk_button_new_with_label("🖨 Export");
+g_signal_connect(export_btn, "clicked", G_CALLBACK(on_export_clicked), &app);
+gtk_box_pack_start(GTK_BOX(hbox), export_btn, FALSE, FALSE, 0);
+
+GtkWidget *dup_btn = gtk_button_new_with_label("⧉ Duplicates");
+g_signal_connect(dup_btn, "clicked", G_CALLBACK(on_duplicates_clicked), &app);
+gtk_box_pack_start(GTK_BOX(hbox), dup_btn, FALSE, FALSE, 0);
+
 gtk_box_pack_start(GTK_BOX(vbox), hbox, FALSE, FALSE, 0);
 
 GtkWidget *scroll = gtk_scrolled_window_new(NULL, NULL);
@@ -719,8 +2714,8 @@ gtk_scrolled_window_set_policy(GTK_SCROLLED_WINDOW(scroll),
                                GTK_POLICY_AUTOMATIC,
                                GTK_POLICY_AUTOMATIC);
 
-app.list_store = gtk_list_store_new(4, G_TYPE_STRING, G_TYPE_STRING, 
-                                    G_TYPE_STRING, G_TYPE_INT);
+app.list_store = gtk_list_store_new(5, G_TYPE_STRING, G_TYPE_STRING, 
+                                    G_TYPE_STRING, G_TYPE_INT, G_TYPE_INT);
 app.list_view = gtk_tree_view_new_with_model(GTK_TREE_MODEL(app.list_store));
 gtk_tree_view_set_headers_visible(GTK_TREE_VIEW(app.list_view), TRUE);
 
@@ -743,11 +2738,42 @@ gtk_tree_view_append_column(GTK_TREE_VIEW(app.list_view), col);
 gtk_container_add(GTK_CONTAINER(scroll), app.list_view);
 gtk_box_pack_start(GTK_BOX(vbox), scroll, TRUE, TRUE, 0);
 
+GtkAdjustment *list_scroll = gtk_scrolled_window_get_vadjustment(GTK_SCROLLED_WINDOW(scroll));
+g_signal_connect(list_scroll, "value-changed", G_CALLBACK(on_list_scrolled), &app);
+g_signal_connect(list_scroll, "changed", G_CALLBACK(on_list_scrolled), &app);
+
 create_form_window(&app);
 refresh_list(&app);
 
 gtk_widget_show_all(app.window);
+
+if (storage_notice) {
+    GtkWidget *dialog = gtk_message_dialog_new(GTK_WINDOW(app.window),
+                                               GTK_DIALOG_MODAL,
+                                               GTK_MESSAGE_INFO,
+                                               GTK_BUTTONS_OK,
+                                               "%s", storage_notice);
+    gtk_dialog_run(GTK_DIALOG(dialog));
+    gtk_widget_destroy(dialog);
+}
+
+if (app.rows_not_loaded > 0) {
+    GtkWidget *dialog = gtk_message_dialog_new(GTK_WINDOW(app.window),
+                                               GTK_DIALOG_MODAL,
+                                               GTK_MESSAGE_WARNING,
+                                               GTK_BUTTONS_OK,
+                                               "Only the first %d algorithms were loaded; "
+                                               "%d more in %s are not shown",
+                                               MAX_ALGOS, app.rows_not_loaded, DATA_FILE);
+    gtk_message_dialog_format_secondary_text(GTK_MESSAGE_DIALOG(dialog),
+        "Saving is disabled so they are not lost. Start with --sqlite to use the whole library.");
+    gtk_dialog_run(GTK_DIALOG(dialog));
+    gtk_widget_destroy(dialog);
+}
 gtk_main();
 
+if (app.db) sqlite3_close(app.db);
+g_free(app.type_filter);
+
 return 0;
 }